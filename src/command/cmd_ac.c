@@ -100,6 +100,7 @@ static char* _sendfile_autocomplete(ProfWin *window, const char *const input);
 static char* _blocked_autocomplete(ProfWin *window, const char *const input);
 static char* _tray_autocomplete(ProfWin *window, const char *const input);
 static char* _presence_autocomplete(ProfWin *window, const char *const input);
+static char* _statusbar_autocomplete(ProfWin *window, const char *const input);
 
 static char* _script_autocomplete_func(const char *const prefix);
 
@@ -185,6 +186,7 @@ static Autocomplete script_show_ac;
 static Autocomplete console_ac;
 static Autocomplete console_msg_ac;
 static Autocomplete autoping_ac;
+static Autocomplete upload_ac;
 static Autocomplete plugins_ac;
 static Autocomplete plugins_load_ac;
 static Autocomplete plugins_unload_ac;
@@ -195,6 +197,9 @@ static Autocomplete tray_ac;
 static Autocomplete presence_ac;
 static Autocomplete presence_setting_ac;
 static Autocomplete winpos_ac;
+static Autocomplete statusbar_ac;
+static Autocomplete statusbar_mode_ac;
+static Autocomplete statusbar_sort_ac;
 
 void
 cmd_ac_init(void)
@@ -707,6 +712,9 @@ cmd_ac_init(void)
     autocomplete_add(autoping_ac, "set");
     autocomplete_add(autoping_ac, "timeout");
 
+    upload_ac = autocomplete_new();
+    autocomplete_add(upload_ac, "concurrency");
+
     plugins_ac = autocomplete_new();
     autocomplete_add(plugins_ac, "install");
     autocomplete_add(plugins_ac, "load");
@@ -740,6 +748,20 @@ cmd_ac_init(void)
     winpos_ac = autocomplete_new();
     autocomplete_add(winpos_ac, "up");
     autocomplete_add(winpos_ac, "down");
+
+    statusbar_ac = autocomplete_new();
+    autocomplete_add(statusbar_ac, "up");
+    autocomplete_add(statusbar_ac, "down");
+    autocomplete_add(statusbar_ac, "mode");
+    autocomplete_add(statusbar_ac, "sort");
+
+    statusbar_mode_ac = autocomplete_new();
+    autocomplete_add(statusbar_mode_ac, "fixed");
+    autocomplete_add(statusbar_mode_ac, "activity");
+
+    statusbar_sort_ac = autocomplete_new();
+    autocomplete_add(statusbar_sort_ac, "number");
+    autocomplete_add(statusbar_sort_ac, "recent");
 }
 
 void
@@ -998,12 +1020,16 @@ cmd_ac_reset(ProfWin *window)
     autocomplete_reset(console_ac);
     autocomplete_reset(console_msg_ac);
     autocomplete_reset(autoping_ac);
+    autocomplete_reset(upload_ac);
     autocomplete_reset(plugins_ac);
     autocomplete_reset(blocked_ac);
     autocomplete_reset(tray_ac);
     autocomplete_reset(presence_ac);
     autocomplete_reset(presence_setting_ac);
     autocomplete_reset(winpos_ac);
+    autocomplete_reset(statusbar_ac);
+    autocomplete_reset(statusbar_mode_ac);
+    autocomplete_reset(statusbar_sort_ac);
 
     autocomplete_reset(script_ac);
     if (script_show_ac) {
@@ -1117,6 +1143,7 @@ cmd_ac_uninit(void)
     autocomplete_free(console_ac);
     autocomplete_free(console_msg_ac);
     autocomplete_free(autoping_ac);
+    autocomplete_free(upload_ac);
     autocomplete_free(plugins_ac);
     autocomplete_free(plugins_load_ac);
     autocomplete_free(plugins_unload_ac);
@@ -1127,6 +1154,9 @@ cmd_ac_uninit(void)
     autocomplete_free(presence_ac);
     autocomplete_free(presence_setting_ac);
     autocomplete_free(winpos_ac);
+    autocomplete_free(statusbar_ac);
+    autocomplete_free(statusbar_mode_ac);
+    autocomplete_free(statusbar_sort_ac);
 }
 
 static char*
@@ -1207,8 +1237,8 @@ _cmd_ac_complete_params(ProfWin *window, const char *const input)
         }
     }
 
-    gchar *cmds[] = { "/prefs", "/disco", "/room", "/autoping", "/titlebar", "/mainwin", "/statusbar", "/inputwin" };
-    Autocomplete completers[] = { prefs_ac, disco_ac, room_ac, autoping_ac, winpos_ac, winpos_ac, winpos_ac, winpos_ac };
+    gchar *cmds[] = { "/prefs", "/disco", "/room", "/autoping", "/upload", "/titlebar", "/mainwin", "/inputwin" };
+    Autocomplete completers[] = { prefs_ac, disco_ac, room_ac, autoping_ac, upload_ac, winpos_ac, winpos_ac, winpos_ac };
 
     for (i = 0; i < ARRAY_SIZE(cmds); i++) {
         result = autocomplete_param_with_ac(input, cmds[i], completers[i], TRUE);
@@ -1258,6 +1288,7 @@ _cmd_ac_complete_params(ProfWin *window, const char *const input)
     g_hash_table_insert(ac_funcs, "/blocked",       _blocked_autocomplete);
     g_hash_table_insert(ac_funcs, "/tray",          _tray_autocomplete);
     g_hash_table_insert(ac_funcs, "/presence",      _presence_autocomplete);
+    g_hash_table_insert(ac_funcs, "/statusbar",     _statusbar_autocomplete);
 
     int len = strlen(input);
     char parsed[len+1];
@@ -2939,6 +2970,29 @@ _presence_autocomplete(ProfWin *window, const char *const input)
     return NULL;
 }
 
+static char*
+_statusbar_autocomplete(ProfWin *window, const char *const input)
+{
+    char *found = NULL;
+
+    found = autocomplete_param_with_ac(input, "/statusbar mode", statusbar_mode_ac, TRUE);
+    if (found) {
+        return found;
+    }
+
+    found = autocomplete_param_with_ac(input, "/statusbar sort", statusbar_sort_ac, TRUE);
+    if (found) {
+        return found;
+    }
+
+    found = autocomplete_param_with_ac(input, "/statusbar", statusbar_ac, TRUE);
+    if (found) {
+        return found;
+    }
+
+    return NULL;
+}
+
 static char*
 _complete_filepath(const char *const input, char *const startstr)
 {
@@ -147,6 +147,21 @@ static struct cmd_t command_defs[] =
         CMD_NOEXAMPLES
     },
 
+    { "/memstats",
+        parse_args, 0, 0, NULL,
+        CMD_NOSUBFUNCS
+        CMD_MAINFUNC(cmd_memstats)
+        CMD_NOTAGS
+        CMD_SYN(
+            "/memstats")
+        CMD_DESC(
+            "Show memory statistics for shared strings such as nicks, resources and group names, "
+            "for the scratch memory used while handling incoming stanzas, "
+            "and for window rendering along with the CPU time used so far.")
+        CMD_NOARGS
+        CMD_NOEXAMPLES
+    },
+
     { "/connect",
         parse_args, 0, 7, NULL,
         CMD_NOSUBFUNCS
@@ -856,12 +871,31 @@ static struct cmd_t command_defs[] =
         CMD_SYN(
             "/sendfile <file>")
         CMD_DESC(
-            "Send a file using XEP-0363 HTTP file transfer.")
+            "Send a file using XEP-0363 HTTP file transfer. "
+            "Several files can be sent at once using a wildcard pattern, they are uploaded a few at a time.")
         CMD_ARGS(
-            { "<file>", "Path to the file." })
+            { "<file>", "Path to the file, or a pattern matching several files." })
         CMD_EXAMPLES(
             "/sendfile /etc/hosts",
-            "/sendfile ~/images/sweet_cat.jpg")
+            "/sendfile ~/images/sweet_cat.jpg",
+            "/sendfile ~/images/holiday/*.jpg")
+    },
+
+    { "/upload",
+        parse_args, 2, 2, &cons_upload_setting,
+        CMD_NOSUBFUNCS
+        CMD_MAINFUNC(cmd_upload)
+        CMD_TAGS(
+            CMD_TAG_CHAT,
+            CMD_TAG_GROUPCHAT)
+        CMD_SYN(
+            "/upload concurrency <count>")
+        CMD_DESC(
+            "Settings for files sent with /sendfile.")
+        CMD_ARGS(
+            { "concurrency <count>", "Number of files uploaded at the same time, further files wait for a free slot. The default is 3." })
+        CMD_EXAMPLES(
+            "/upload concurrency 1")
     },
 
     { "/lastactivity",
@@ -1337,20 +1371,28 @@ static struct cmd_t command_defs[] =
     },
 
     { "/statusbar",
-        parse_args, 1, 1, &cons_winpos_setting,
+        parse_args, 1, 2, &cons_statusbar_setting,
         CMD_NOSUBFUNCS
         CMD_MAINFUNC(cmd_statusbar)
         CMD_TAGS(
             CMD_TAG_UI)
         CMD_SYN(
             "/statusbar up",
-            "/statusbar down")
+            "/statusbar down",
+            "/statusbar mode fixed|activity",
+            "/statusbar sort number|recent")
         CMD_DESC(
-            "Move the status bar.")
+            "Move the status bar, and configure how window indicators are shown.")
         CMD_ARGS(
             { "up", "Move the status bar up the screen." },
-            { "down", "Move the status bar down the screen." })
-        CMD_NOEXAMPLES
+            { "down", "Move the status bar down the screen." },
+            { "mode fixed", "Show indicators for windows 1 to 10, with a single indicator for all higher windows." },
+            { "mode activity", "Show the current window, and only those windows with new messages." },
+            { "sort number", "In activity mode, order windows by window number." },
+            { "sort recent", "In activity mode, show windows with the most recent activity first." })
+        CMD_EXAMPLES(
+            "/statusbar mode activity",
+            "/statusbar sort recent")
     },
 
     { "/inputwin",
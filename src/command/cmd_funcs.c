@@ -44,10 +44,12 @@
 #include <glib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <langinfo.h>
 #include <ctype.h>
+#include <glob.h>
 
 #include "profanity.h"
 #include "log.h"
@@ -66,6 +68,7 @@
 #include "tools/autocomplete.h"
 #include "tools/parser.h"
 #include "tools/tinyurl.h"
+#include "tools/intern.h"
 #include "plugins/plugins.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
@@ -1591,6 +1594,51 @@ cmd_about(ProfWin *window, const char *const command, gchar **args)
     return TRUE;
 }
 
+gboolean
+cmd_memstats(ProfWin *window, const char *const command, gchar **args)
+{
+    gulong lookups = intern_get_lookups();
+    gulong hits = intern_get_hits();
+    int hit_rate = lookups > 0 ? (int)((hits * 100) / lookups) : 0;
+
+    cons_show("");
+    cons_show("Shared strings   : %u", intern_get_count());
+    cons_show("Bytes            : %lu", (unsigned long)intern_get_bytes());
+    cons_show("References       : %lu", intern_get_refs());
+    cons_show("Lookups          : %lu", lookups);
+    cons_show("Hit rate         : %d%%", hit_rate);
+
+    Arena arena = connection_stanza_arena();
+    if (arena) {
+        cons_show("");
+        cons_show("Stanza arena allocations : %lu", arena_get_allocs(arena));
+        cons_show("Stanza arena blocks      : %lu", arena_get_blocks(arena));
+        cons_show("Stanzas handled          : %lu", arena_get_resets(arena));
+        cons_show("Serialisations avoided   : %lu", connection_get_stanza_text_skipped());
+    }
+
+    cons_show("");
+    cons_show("Window lines drawn       : %lu", win_get_lines_drawn());
+    cons_show("Window lines deferred    : %lu", win_get_lines_deferred());
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        cons_show("CPU time                 : %ld.%03lds user, %ld.%03lds system",
+            (long)usage.ru_utime.tv_sec, (long)usage.ru_utime.tv_usec / 1000,
+            (long)usage.ru_stime.tv_sec, (long)usage.ru_stime.tv_usec / 1000);
+    }
+
+#ifdef HAVE_LIBGPGME
+    cons_show("");
+    cons_show("PGP verify cache hits    : %lu", p_gpg_verify_cache_hits());
+    cons_show("PGP verify cache misses  : %lu", p_gpg_verify_cache_misses());
+    cons_show("PGP key index            : %u keys, built in %ldms", p_gpg_key_index_count(),
+        (long)(p_gpg_key_index_build_time() / 1000));
+#endif
+
+    return TRUE;
+}
+
 gboolean
 cmd_prefs(ProfWin *window, const char *const command, gchar **args)
 {
@@ -4468,6 +4516,35 @@ cmd_disco(ProfWin *window, const char *const command, gchar **args)
     return TRUE;
 }
 
+static void
+_cmd_sendfile_path(ProfWin *window, const char *const path)
+{
+    if (access(path, R_OK) != 0) {
+        cons_show_error("Uploading '%s' failed: File not found!", path);
+        return;
+    }
+
+    off_t size = 0;
+    char *mime_type = NULL;
+    if (!file_upload_info(path, &size, &mime_type)) {
+        cons_show_error("Uploading '%s' failed: Not a file!", path);
+        return;
+    }
+
+    HTTPUpload *upload = malloc(sizeof(HTTPUpload));
+    upload->window = window;
+    upload->bytes_sent = 0;
+    upload->cancel = 0;
+    upload->progress = 0;
+    upload->progress_shown = 0;
+
+    upload->filename = strdup(path);
+    upload->filesize = size;
+    upload->mime_type = mime_type;
+
+    iq_http_upload_request(upload);
+}
+
 gboolean
 cmd_sendfile(ProfWin *window, const char *const command, gchar **args)
 {
@@ -4495,26 +4572,23 @@ cmd_sendfile(ProfWin *window, const char *const command, gchar **args)
         return TRUE;
     }
 
-    if (access(filename, R_OK) != 0) {
-        cons_show_error("Uploading '%s' failed: File not found!", filename);
-        free(filename);
-        return TRUE;
-    }
-
-    if (!is_regular_file(filename)) {
-        cons_show_error("Uploading '%s' failed: Not a file!", filename);
-        free(filename);
-        return TRUE;
+    // a path naming an existing file is sent as is, anything else may be a pattern for several files
+    if (access(filename, F_OK) == 0) {
+        _cmd_sendfile_path(window, filename);
+    } else {
+        glob_t files;
+        if (glob(filename, GLOB_NOCHECK, NULL, &files) == 0) {
+            size_t i;
+            for (i = 0; i < files.gl_pathc; i++) {
+                _cmd_sendfile_path(window, files.gl_pathv[i]);
+            }
+        } else {
+            _cmd_sendfile_path(window, filename);
+        }
+        globfree(&files);
     }
 
-    HTTPUpload *upload = malloc(sizeof(HTTPUpload));
-    upload->window = window;
-
-    upload->filename = filename;
-    upload->filesize = file_size(filename);
-    upload->mime_type = file_mime_type(filename);
-
-    iq_http_upload_request(upload);
+    free(filename);
 
     return TRUE;
 }
@@ -5608,6 +5682,28 @@ cmd_statusbar(ProfWin *window, const char *const command, gchar **args)
 
         return TRUE;
     }
+    if (g_strcmp0(args[0], "mode") == 0) {
+        if (g_strcmp0(args[1], "fixed") == 0 || g_strcmp0(args[1], "activity") == 0) {
+            prefs_set_string(PREF_STATUSBAR_MODE, args[1]);
+            ui_resize();
+            cons_show("Status bar mode set to: %s.", args[1]);
+        } else {
+            cons_bad_cmd_usage(command);
+        }
+
+        return TRUE;
+    }
+    if (g_strcmp0(args[0], "sort") == 0) {
+        if (g_strcmp0(args[1], "number") == 0 || g_strcmp0(args[1], "recent") == 0) {
+            prefs_set_string(PREF_STATUSBAR_SORT, args[1]);
+            ui_resize();
+            cons_show("Status bar sort set to: %s.", args[1]);
+        } else {
+            cons_bad_cmd_usage(command);
+        }
+
+        return TRUE;
+    }
 
     cons_bad_cmd_usage(command);
 
@@ -5774,6 +5870,33 @@ cmd_autoping(ProfWin *window, const char *const command, gchar **args)
     return TRUE;
 }
 
+gboolean
+cmd_upload(ProfWin *window, const char *const command, gchar **args)
+{
+    char *cmd = args[0];
+    char *value = args[1];
+
+    if (g_strcmp0(cmd, "concurrency") == 0) {
+        int intval = 0;
+        char *err_msg = NULL;
+        gboolean res = strtoi_range(value, &intval, 1, INT_MAX, &err_msg);
+        if (res) {
+            prefs_set_upload_concurrency(intval);
+            http_upload_set_concurrency(intval);
+            cons_show("Upload concurrency set to %d.", intval);
+        } else {
+            cons_show(err_msg);
+            cons_bad_cmd_usage(command);
+            free(err_msg);
+        }
+
+    } else {
+        cons_bad_cmd_usage(command);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_ping(ProfWin *window, const char *const command, gchar **args)
 {
@@ -6734,6 +6857,12 @@ cmd_otr_start(ProfWin *window, const char *const command, gchar **args)
             return TRUE;
         }
 
+        if (otr_keygen_in_progress()) {
+            otr_keygen_queue_start(barejid);
+            ui_current_print_formatted_line('!', 0, "Private key generation in progress, the OTR session will start when it completes.");
+            return TRUE;
+        }
+
         if (!otr_key_loaded()) {
             ui_current_print_formatted_line('!', 0, "You have not generated or loaded a private key, use '/otr gen'");
             return TRUE;
@@ -6768,6 +6897,12 @@ cmd_otr_start(ProfWin *window, const char *const command, gchar **args)
             return TRUE;
         }
 
+        if (otr_keygen_in_progress()) {
+            otr_keygen_queue_start(chatwin->barejid);
+            ui_current_print_formatted_line('!', 0, "Private key generation in progress, the OTR session will start when it completes.");
+            return TRUE;
+        }
+
         if (!otr_key_loaded()) {
             ui_current_print_formatted_line('!', 0, "You have not generated or loaded a private key, use '/otr gen'");
             return TRUE;
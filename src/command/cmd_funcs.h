@@ -74,9 +74,11 @@ gboolean cmd_process_input(ProfWin *window, char *inp);
 void cmd_execute_connect(ProfWin *window, const char *const account);
 
 gboolean cmd_about(ProfWin *window, const char *const command, gchar **args);
+gboolean cmd_memstats(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_autoaway(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_autoconnect(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_autoping(ProfWin *window, const char *const command, gchar **args);
+gboolean cmd_upload(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_away(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_beep(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_caps(ProfWin *window, const char *const command, gchar **args);
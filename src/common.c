@@ -262,6 +262,34 @@ strtoi_range(char *str, int *saveptr, int min, int max, char **err_msg)
     return TRUE;
 }
 
+size_t
+utf8_ascii_prefix_len(const char *const str, size_t len)
+{
+    if (!str) {
+        return 0;
+    }
+
+    // check a machine word at a time while a whole word is left before the
+    // terminator, the rest bytewise, so nothing past the string is read
+    const char *curr = str;
+    const char *end = str + len;
+    const uint64_t high = 0x8080808080808080ULL;
+    const uint64_t low = 0x0101010101010101ULL;
+    while ((size_t)(end - curr) >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, curr, sizeof(word));
+        if ((word & high) || ((word - low) & ~word & high)) {
+            break;
+        }
+        curr += sizeof(word);
+    }
+    while (curr < end && *curr != '\0' && !(*curr & 0x80)) {
+        curr++;
+    }
+
+    return curr - str;
+}
+
 int
 utf8_display_len(const char *const str)
 {
@@ -269,9 +297,16 @@ utf8_display_len(const char *const str)
         return 0;
     }
 
-    int len = 0;
-    gchar *curr = g_utf8_offset_to_pointer(str, 0);
+    // ASCII characters are always one column wide
+    size_t ascii = utf8_ascii_prefix_len(str, strlen(str));
+    int len = ascii;
+    const gchar *curr = str + ascii;
     while (*curr != '\0') {
+        if (!(*curr & 0x80)) {
+            len++;
+            curr++;
+            continue;
+        }
         gunichar curru = g_utf8_get_char(curr);
         if (g_unichar_iswide(curru)) {
             len += 2;
@@ -106,6 +106,7 @@ gboolean copy_file(const char *const src, const char *const target);
 char* str_replace(const char *string, const char *substr, const char *replacement);
 int str_contains(const char str[], int size, char ch);
 gboolean strtoi_range(char *str, int *saveptr, int min, int max, char **err_msg);
+size_t utf8_ascii_prefix_len(const char *const str, size_t len);
 int utf8_display_len(const char *const str);
 char* file_getline(FILE *stream);
 
@@ -45,12 +45,14 @@
 #include "config/files.h"
 #include "config/account.h"
 #include "config/conflists.h"
+#include "config/persist.h"
 #include "tools/autocomplete.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/jid.h"
 
 static char *accounts_loc;
 static GKeyFile *accounts;
+static PersistStore *accounts_store;
 
 static Autocomplete all_ac;
 static Autocomplete enabled_ac;
@@ -71,6 +73,7 @@ accounts_load(void)
 
     accounts = g_key_file_new();
     g_key_file_load_from_file(accounts, accounts_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    accounts_store = persist_store_new(accounts, accounts_loc, PERSIST_DEFAULT_DELAY);
 
     // create the logins searchable list for autocompletion
     gsize naccounts;
@@ -92,6 +95,8 @@ accounts_close(void)
 {
     autocomplete_free(all_ac);
     autocomplete_free(enabled_ac);
+    persist_store_free(accounts_store);
+    accounts_store = NULL;
     g_key_file_free(accounts);
 }
 
@@ -855,15 +860,5 @@ accounts_get_login_presence(const char *const account_name)
 static void
 _save_accounts(void)
 {
-    gsize g_data_size;
-    gchar *g_accounts_data = g_key_file_to_data(accounts, &g_data_size, NULL);
-
-    gchar *base = g_path_get_basename(accounts_loc);
-    gchar *true_loc = get_file_or_linked(accounts_loc, base);
-    g_file_set_contents(true_loc, g_accounts_data, g_data_size, NULL);
-    g_chmod(accounts_loc, S_IRUSR | S_IWUSR);
-
-    g_free(base);
-    free(true_loc);
-    g_free(g_accounts_data);
+    persist_store_mark_dirty(accounts_store);
 }
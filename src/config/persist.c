@@ -0,0 +1,192 @@
+/*
+ * persist.c
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "log.h"
+#include "common.h"
+#include "config/persist.h"
+
+struct persist_store_t {
+    GKeyFile *keyfile;
+    char *path;
+    int delay;
+    gboolean dirty;
+    GTimer *timer;
+    gsize last_size;
+};
+
+static GList *stores = NULL;
+
+static unsigned long writes = 0;
+static unsigned long writes_avoided = 0;
+static unsigned long bytes_avoided = 0;
+
+static void _persist_store_write(PersistStore *store);
+
+PersistStore*
+persist_store_new(GKeyFile *keyfile, const char *const path, int delay)
+{
+    PersistStore *store = malloc(sizeof(PersistStore));
+    store->keyfile = keyfile;
+    store->path = strdup(path);
+    store->delay = delay;
+    store->dirty = FALSE;
+    store->timer = g_timer_new();
+    store->last_size = 0;
+
+    stores = g_list_append(stores, store);
+
+    return store;
+}
+
+void
+persist_store_free(PersistStore *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    persist_store_flush(store);
+
+    stores = g_list_remove(stores, store);
+    g_timer_destroy(store->timer);
+    free(store->path);
+    free(store);
+}
+
+void
+persist_store_mark_dirty(PersistStore *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    if (store->dirty) {
+        // coalesced into the write already scheduled
+        writes_avoided++;
+        bytes_avoided += store->last_size;
+        return;
+    }
+
+    store->dirty = TRUE;
+    g_timer_start(store->timer);
+
+    if (store->delay <= 0) {
+        _persist_store_write(store);
+    }
+}
+
+void
+persist_store_flush(PersistStore *store)
+{
+    if (store && store->dirty) {
+        _persist_store_write(store);
+    }
+}
+
+void
+persist_check(void)
+{
+    GList *curr = stores;
+    while (curr) {
+        PersistStore *store = curr->data;
+        if (store->dirty && g_timer_elapsed(store->timer, NULL) >= store->delay) {
+            _persist_store_write(store);
+        }
+        curr = g_list_next(curr);
+    }
+}
+
+void
+persist_flush_all(void)
+{
+    GList *curr = stores;
+    while (curr) {
+        persist_store_flush(curr->data);
+        curr = g_list_next(curr);
+    }
+}
+
+unsigned long
+persist_get_writes(void)
+{
+    return writes;
+}
+
+unsigned long
+persist_get_writes_avoided(void)
+{
+    return writes_avoided;
+}
+
+unsigned long
+persist_get_bytes_avoided(void)
+{
+    return bytes_avoided;
+}
+
+static void
+_persist_store_write(PersistStore *store)
+{
+    gsize g_data_size;
+    gchar *g_data = g_key_file_to_data(store->keyfile, &g_data_size, NULL);
+
+    gchar *base = g_path_get_basename(store->path);
+    gchar *true_loc = get_file_or_linked(store->path, base);
+
+    // written to a temporary file and renamed over the original
+    GError *err = NULL;
+    if (g_file_set_contents(true_loc, g_data, g_data_size, &err)) {
+        g_chmod(store->path, S_IRUSR | S_IWUSR);
+        store->dirty = FALSE;
+        store->last_size = g_data_size;
+        writes++;
+    } else {
+        log_error("Failed to write %s: %s", true_loc, err ? err->message : "unknown error");
+        if (err) {
+            g_error_free(err);
+        }
+        // stay dirty, persist_check retries after another delay
+        g_timer_start(store->timer);
+    }
+
+    g_free(base);
+    free(true_loc);
+    g_free(g_data);
+}
@@ -0,0 +1,57 @@
+/*
+ * persist.h
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef CONFIG_PERSIST_H
+#define CONFIG_PERSIST_H
+
+#include <glib.h>
+
+// seconds a changed store waits for further changes before it is written
+#define PERSIST_DEFAULT_DELAY 2
+
+typedef struct persist_store_t PersistStore;
+
+PersistStore* persist_store_new(GKeyFile *keyfile, const char *const path, int delay);
+void persist_store_free(PersistStore *store);
+void persist_store_mark_dirty(PersistStore *store);
+void persist_store_flush(PersistStore *store);
+
+void persist_check(void);
+void persist_flush_all(void);
+
+unsigned long persist_get_writes(void);
+unsigned long persist_get_writes_avoided(void);
+unsigned long persist_get_bytes_avoided(void);
+
+#endif
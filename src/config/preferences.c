@@ -47,6 +47,7 @@
 #include "tools/autocomplete.h"
 #include "config/files.h"
 #include "config/conflists.h"
+#include "config/persist.h"
 
 // preference groups refer to the sections in .profrc, for example [ui]
 #define PREF_GROUP_LOGGING "logging"
@@ -64,10 +65,12 @@
 
 static char *prefs_loc;
 static GKeyFile *prefs;
+static PersistStore *prefs_store;
 gint log_maxsize = 0;
 
 static Autocomplete boolean_choice_ac;
 static Autocomplete room_trigger_ac;
+static int room_triggers_version = 0;
 
 static void _save_prefs(void);
 static const char* _get_group(preference_t pref);
@@ -87,6 +90,7 @@ prefs_load(void)
 
     prefs = g_key_file_new();
     g_key_file_load_from_file(prefs, prefs_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    prefs_store = persist_store_new(prefs, prefs_loc, PERSIST_DEFAULT_DELAY);
 
     err = NULL;
     log_maxsize = g_key_file_get_integer(prefs, PREF_GROUP_LOGGING, "maxsize", &err);
@@ -162,6 +166,7 @@ prefs_load(void)
     autocomplete_add(boolean_choice_ac, "off");
 
     room_trigger_ac = autocomplete_new();
+    room_triggers_version++;
     gsize len = 0;
     gchar **triggers = g_key_file_get_string_list(prefs, PREF_GROUP_NOTIFICATIONS, "room.trigger.list", &len, NULL);
 
@@ -177,6 +182,8 @@ prefs_close(void)
 {
     autocomplete_free(boolean_choice_ac);
     autocomplete_free(room_trigger_ac);
+    persist_store_free(prefs_store);
+    prefs_store = NULL;
     g_key_file_free(prefs);
     prefs = NULL;
 }
@@ -219,28 +226,6 @@ prefs_do_chat_notify(gboolean current_win)
     }
 }
 
-GList*
-prefs_message_get_triggers(const char *const message)
-{
-    GList *result = NULL;
-
-    char *message_lower = g_utf8_strdown(message, -1);
-    gsize len = 0;
-    gchar **triggers = g_key_file_get_string_list(prefs, PREF_GROUP_NOTIFICATIONS, "room.trigger.list", &len, NULL);
-    int i;
-    for (i = 0; i < len; i++) {
-        char *trigger_lower = g_utf8_strdown(triggers[i], -1);
-        if (g_strrstr(message_lower, trigger_lower)) {
-            result = g_list_append(result, strdup(triggers[i]));
-        }
-        g_free(trigger_lower);
-    }
-    g_strfreev(triggers);
-    g_free(message_lower);
-
-    return result;
-}
-
 gboolean
 prefs_do_room_notify(gboolean current_win, const char *const roomjid, const char *const mynick,
     const char *const theirnick, const char *const message, gboolean mention, gboolean trigger_found)
@@ -555,6 +540,24 @@ prefs_set_autoping(gint value)
     _save_prefs();
 }
 
+gint
+prefs_get_upload_concurrency(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_CONNECTION, "upload.concurrency", NULL)) {
+        return 3;
+    } else {
+        gint value = g_key_file_get_integer(prefs, PREF_GROUP_CONNECTION, "upload.concurrency", NULL);
+        return value < 1 ? 1 : value;
+    }
+}
+
+void
+prefs_set_upload_concurrency(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_CONNECTION, "upload.concurrency", value);
+    _save_prefs();
+}
+
 gint
 prefs_get_autoping_timeout(void)
 {
@@ -1026,6 +1029,7 @@ prefs_add_room_notify_trigger(const char * const text)
 
     if (res) {
         autocomplete_add(room_trigger_ac, text);
+        room_triggers_version++;
     }
 
     return res;
@@ -1039,11 +1043,18 @@ prefs_remove_room_notify_trigger(const char * const text)
 
     if (res) {
         autocomplete_remove(room_trigger_ac, text);
+        room_triggers_version++;
     }
 
     return res;
 }
 
+int
+prefs_get_room_notify_triggers_version(void)
+{
+    return room_triggers_version;
+}
+
 GList*
 prefs_get_room_notify_triggers(void)
 {
@@ -1451,17 +1462,7 @@ prefs_free_aliases(GList *aliases)
 static void
 _save_prefs(void)
 {
-    gsize g_data_size;
-    gchar *g_prefs_data = g_key_file_to_data(prefs, &g_data_size, NULL);
-    gchar *base = g_path_get_basename(prefs_loc);
-    gchar *true_loc = get_file_or_linked(prefs_loc, base);
-
-    g_file_set_contents(true_loc, g_prefs_data, g_data_size, NULL);
-    g_chmod(prefs_loc, S_IRUSR | S_IWUSR);
-
-    g_free(base);
-    free(true_loc);
-    g_free(g_prefs_data);
+    persist_store_mark_dirty(prefs_store);
 }
 
 // get the preference group for a specific preference
@@ -1529,6 +1530,8 @@ _get_group(preference_t pref)
         case PREF_CONSOLE_MUC:
         case PREF_CONSOLE_PRIVATE:
         case PREF_CONSOLE_CHAT:
+        case PREF_STATUSBAR_MODE:
+        case PREF_STATUSBAR_SORT:
             return PREF_GROUP_UI;
         case PREF_STATES:
         case PREF_OUTTYPE:
@@ -1775,6 +1778,10 @@ _get_key(preference_t pref)
             return "console.chat";
         case PREF_BOOKMARK_INVITE:
             return "bookmark.invite";
+        case PREF_STATUSBAR_MODE:
+            return "statusbar.mode";
+        case PREF_STATUSBAR_SORT:
+            return "statusbar.sort";
         default:
             return NULL;
     }
@@ -1885,6 +1892,10 @@ _get_default_string(preference_t pref)
         case PREF_CONSOLE_PRIVATE:
         case PREF_CONSOLE_CHAT:
             return "all";
+        case PREF_STATUSBAR_MODE:
+            return "fixed";
+        case PREF_STATUSBAR_SORT:
+            return "number";
         default:
             return NULL;
     }
@@ -141,6 +141,8 @@ typedef enum {
     PREF_CONSOLE_PRIVATE,
     PREF_CONSOLE_CHAT,
     PREF_BOOKMARK_INVITE,
+    PREF_STATUSBAR_MODE,
+    PREF_STATUSBAR_SORT,
 } preference_t;
 
 typedef struct prof_alias_t {
@@ -182,6 +184,8 @@ void prefs_set_autoping(gint value);
 gint prefs_get_autoping(void);
 void prefs_set_autoping_timeout(gint value);
 gint prefs_get_autoping_timeout(void);
+gint prefs_get_upload_concurrency(void);
+void prefs_set_upload_concurrency(gint value);
 gint prefs_get_inpblock(void);
 void prefs_set_inpblock(gint value);
 
@@ -245,6 +249,7 @@ void prefs_free_aliases(GList *aliases);
 gboolean prefs_add_room_notify_trigger(const char * const text);
 gboolean prefs_remove_room_notify_trigger(const char * const text);
 GList* prefs_get_room_notify_triggers(void);
+int prefs_get_room_notify_triggers_version(void);
 
 ProfWinPlacement* prefs_get_win_placement(void);
 void prefs_free_win_placement(ProfWinPlacement *placement);
@@ -270,7 +275,6 @@ gboolean prefs_do_chat_notify(gboolean current_win);
 gboolean prefs_do_room_notify(gboolean current_win, const char *const roomjid, const char *const mynick,
     const char *const theirnick, const char *const message, gboolean mention, gboolean trigger_found);
 gboolean prefs_do_room_notify_mention(const char *const roomjid, int unread, gboolean mention, gboolean trigger);
-GList* prefs_message_get_triggers(const char *const message);
 
 void prefs_set_room_notify(const char *const roomjid, gboolean value);
 void prefs_set_room_notify_mention(const char *const roomjid, gboolean value);
@@ -42,10 +42,12 @@
 #include "common.h"
 #include "config/files.h"
 #include "config/tlscerts.h"
+#include "config/persist.h"
 #include "tools/autocomplete.h"
 
 static char *tlscerts_loc;
 static GKeyFile *tlscerts;
+static PersistStore *tlscerts_store;
 
 static void _save_tlscerts(void);
 
@@ -65,6 +67,7 @@ tlscerts_init(void)
 
     tlscerts = g_key_file_new();
     g_key_file_load_from_file(tlscerts, tlscerts_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    tlscerts_store = persist_store_new(tlscerts, tlscerts_loc, PERSIST_DEFAULT_DELAY);
 
     certs_ac = autocomplete_new();
     gsize len = 0;
@@ -419,6 +422,8 @@ tlscerts_free(TLSCertificate *cert)
 void
 tlscerts_close(void)
 {
+    persist_store_free(tlscerts_store);
+    tlscerts_store = NULL;
     g_key_file_free(tlscerts);
     tlscerts = NULL;
 
@@ -431,9 +436,5 @@ tlscerts_close(void)
 static void
 _save_tlscerts(void)
 {
-    gsize g_data_size;
-    gchar *g_tlscerts_data = g_key_file_to_data(tlscerts, &g_data_size, NULL);
-    g_file_set_contents(tlscerts_loc, g_tlscerts_data, g_data_size, NULL);
-    g_chmod(tlscerts_loc, S_IRUSR | S_IWUSR);
-    g_free(g_tlscerts_data);
+    persist_store_mark_dirty(tlscerts_store);
 }
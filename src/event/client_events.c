@@ -35,6 +35,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 
 #include "log.h"
@@ -108,6 +109,59 @@ cl_ev_presence_send(const resource_presence_t presence_type, const char *const m
     free(signed_status);
 }
 
+#ifdef HAVE_LIBGPGME
+struct queued_msg_t {
+    char *barejid;
+    char *msg;
+    char *oob_url;
+    gboolean request_receipt;
+};
+
+// sent once the pgp messages queued before it for the same contact have gone
+static void
+_cl_ev_send_msg_queued(const char *const result, void *userdata)
+{
+    struct queued_msg_t *queued = userdata;
+
+    // the window may have been closed while the message waited
+    ProfChatWin *chatwin = wins_get_chat(queued->barejid);
+    if (!chatwin) {
+        chatwin = chatwin_new(queued->barejid);
+    }
+
+#ifdef HAVE_LIBOTR
+    gboolean handled = otr_on_message_send(chatwin, queued->msg, queued->request_receipt);
+#else
+    gboolean handled = FALSE;
+#endif
+    if (!handled) {
+        char *id = message_send_chat(queued->barejid, queued->msg, queued->oob_url, queued->request_receipt);
+        chat_log_msg_out(queued->barejid, queued->msg);
+        chatwin_outgoing_msg(chatwin, queued->msg, id, PROF_MSG_PLAIN, queued->request_receipt);
+        free(id);
+    }
+
+    plugins_post_chat_message_send(queued->barejid, queued->msg);
+
+    free(queued->barejid);
+    free(queued->msg);
+    free(queued->oob_url);
+    free(queued);
+}
+
+// queued behind pending pgp jobs as a job with nothing to decrypt, so it cannot overtake them
+static void
+_cl_ev_queue_msg(ProfChatWin *chatwin, const char *const msg, const char *const oob_url, gboolean request_receipt)
+{
+    struct queued_msg_t *queued = malloc(sizeof(struct queued_msg_t));
+    queued->barejid = strdup(chatwin->barejid);
+    queued->msg = strdup(msg);
+    queued->oob_url = oob_url ? strdup(oob_url) : NULL;
+    queued->request_receipt = request_receipt;
+    p_gpg_decrypt_async(chatwin->barejid, NULL, _cl_ev_send_msg_queued, queued);
+}
+#endif
+
 void
 cl_ev_send_msg(ProfChatWin *chatwin, const char *const msg, const char *const oob_url)
 {
@@ -129,26 +183,32 @@ cl_ev_send_msg(ProfChatWin *chatwin, const char *const msg, const char *const oo
     }
 
     char *plugin_msg = plugins_pre_chat_message_send(chatwin->barejid, msg);
+    const char *send_msg = plugin_msg ? plugin_msg : msg;
 
 // OTR suported, PGP supported
 #ifdef HAVE_LIBOTR
 #ifdef HAVE_LIBGPGME
     if (chatwin->pgp_send) {
-        char *id = message_send_chat_pgp(chatwin->barejid, plugin_msg, request_receipt);
-        chat_log_pgp_msg_out(chatwin->barejid, plugin_msg);
-        chatwin_outgoing_msg(chatwin, plugin_msg, id, PROF_MSG_PGP, request_receipt);
+        // encrypted in the background, shown as pending until it has been sent
+        char *id = message_send_chat_pgp(chatwin->barejid, send_msg, request_receipt);
+        chat_log_pgp_msg_out(chatwin->barejid, send_msg);
+        chatwin_outgoing_msg(chatwin, send_msg, id, PROF_MSG_PGP, TRUE);
         free(id);
+    } else if (p_gpg_pending(chatwin->barejid)) {
+        _cl_ev_queue_msg(chatwin, send_msg, oob_url, request_receipt);
+        free(plugin_msg);
+        return;
     } else {
-        gboolean handled = otr_on_message_send(chatwin, plugin_msg, request_receipt);
+        gboolean handled = otr_on_message_send(chatwin, send_msg, request_receipt);
         if (!handled) {
-            char *id = message_send_chat(chatwin->barejid, plugin_msg, oob_url, request_receipt);
-            chat_log_msg_out(chatwin->barejid, plugin_msg);
-            chatwin_outgoing_msg(chatwin, plugin_msg, id, PROF_MSG_PLAIN, request_receipt);
+            char *id = message_send_chat(chatwin->barejid, send_msg, oob_url, request_receipt);
+            chat_log_msg_out(chatwin->barejid, send_msg);
+            chatwin_outgoing_msg(chatwin, send_msg, id, PROF_MSG_PLAIN, request_receipt);
             free(id);
         }
     }
 
-    plugins_post_chat_message_send(chatwin->barejid, plugin_msg);
+    plugins_post_chat_message_send(chatwin->barejid, send_msg);
     free(plugin_msg);
     return;
 #endif
@@ -157,15 +217,15 @@ cl_ev_send_msg(ProfChatWin *chatwin, const char *const msg, const char *const oo
 // OTR supported, PGP unsupported
 #ifdef HAVE_LIBOTR
 #ifndef HAVE_LIBGPGME
-    gboolean handled = otr_on_message_send(chatwin, plugin_msg, request_receipt);
+    gboolean handled = otr_on_message_send(chatwin, send_msg, request_receipt);
     if (!handled) {
-        char *id = message_send_chat(chatwin->barejid, plugin_msg, oob_url, request_receipt);
-        chat_log_msg_out(chatwin->barejid, plugin_msg);
-        chatwin_outgoing_msg(chatwin, plugin_msg, id, PROF_MSG_PLAIN, request_receipt);
+        char *id = message_send_chat(chatwin->barejid, send_msg, oob_url, request_receipt);
+        chat_log_msg_out(chatwin->barejid, send_msg);
+        chatwin_outgoing_msg(chatwin, send_msg, id, PROF_MSG_PLAIN, request_receipt);
         free(id);
     }
 
-    plugins_post_chat_message_send(chatwin->barejid, plugin_msg);
+    plugins_post_chat_message_send(chatwin->barejid, send_msg);
     free(plugin_msg);
     return;
 #endif
@@ -175,18 +235,23 @@ cl_ev_send_msg(ProfChatWin *chatwin, const char *const msg, const char *const oo
 #ifndef HAVE_LIBOTR
 #ifdef HAVE_LIBGPGME
     if (chatwin->pgp_send) {
-        char *id = message_send_chat_pgp(chatwin->barejid, plugin_msg, request_receipt);
-        chat_log_pgp_msg_out(chatwin->barejid, plugin_msg);
-        chatwin_outgoing_msg(chatwin, plugin_msg, id, PROF_MSG_PGP, request_receipt);
+        // encrypted in the background, shown as pending until it has been sent
+        char *id = message_send_chat_pgp(chatwin->barejid, send_msg, request_receipt);
+        chat_log_pgp_msg_out(chatwin->barejid, send_msg);
+        chatwin_outgoing_msg(chatwin, send_msg, id, PROF_MSG_PGP, TRUE);
         free(id);
+    } else if (p_gpg_pending(chatwin->barejid)) {
+        _cl_ev_queue_msg(chatwin, send_msg, oob_url, request_receipt);
+        free(plugin_msg);
+        return;
     } else {
-        char *id = message_send_chat(chatwin->barejid, plugin_msg, oob_url, request_receipt);
-        chat_log_msg_out(chatwin->barejid, plugin_msg);
-        chatwin_outgoing_msg(chatwin, plugin_msg, id, PROF_MSG_PLAIN, request_receipt);
+        char *id = message_send_chat(chatwin->barejid, send_msg, oob_url, request_receipt);
+        chat_log_msg_out(chatwin->barejid, send_msg);
+        chatwin_outgoing_msg(chatwin, send_msg, id, PROF_MSG_PLAIN, request_receipt);
         free(id);
     }
 
-    plugins_post_chat_message_send(chatwin->barejid, plugin_msg);
+    plugins_post_chat_message_send(chatwin->barejid, send_msg);
     free(plugin_msg);
     return;
 #endif
@@ -195,12 +260,12 @@ cl_ev_send_msg(ProfChatWin *chatwin, const char *const msg, const char *const oo
 // OTR unsupported, PGP unsupported
 #ifndef HAVE_LIBOTR
 #ifndef HAVE_LIBGPGME
-    char *id = message_send_chat(chatwin->barejid, plugin_msg, oob_url, request_receipt);
-    chat_log_msg_out(chatwin->barejid, plugin_msg);
-    chatwin_outgoing_msg(chatwin, plugin_msg, id, PROF_MSG_PLAIN, request_receipt);
+    char *id = message_send_chat(chatwin->barejid, send_msg, oob_url, request_receipt);
+    chat_log_msg_out(chatwin->barejid, send_msg);
+    chatwin_outgoing_msg(chatwin, send_msg, id, PROF_MSG_PLAIN, request_receipt);
     free(id);
 
-    plugins_post_chat_message_send(chatwin->barejid, plugin_msg);
+    plugins_post_chat_message_send(chatwin->barejid, send_msg);
     free(plugin_msg);
     return;
 #endif
@@ -211,10 +276,11 @@ void
 cl_ev_send_muc_msg(ProfMucWin *mucwin, const char *const msg, const char *const oob_url)
 {
     char *plugin_msg = plugins_pre_room_message_send(mucwin->roomjid, msg);
+    const char *send_msg = plugin_msg ? plugin_msg : msg;
 
-    message_send_groupchat(mucwin->roomjid, plugin_msg, oob_url);
+    message_send_groupchat(mucwin->roomjid, send_msg, oob_url);
 
-    plugins_post_room_message_send(mucwin->roomjid, plugin_msg);
+    plugins_post_room_message_send(mucwin->roomjid, send_msg);
     free(plugin_msg);
 }
 
@@ -227,11 +293,12 @@ cl_ev_send_priv_msg(ProfPrivateWin *privwin, const char *const msg, const char *
         privwin_message_left_room(privwin);
     } else {
         char *plugin_msg = plugins_pre_priv_message_send(privwin->fulljid, msg);
+        const char *send_msg = plugin_msg ? plugin_msg : msg;
 
-        message_send_private(privwin->fulljid, plugin_msg, oob_url);
-        privwin_outgoing_msg(privwin, plugin_msg);
+        message_send_private(privwin->fulljid, send_msg, oob_url);
+        privwin_outgoing_msg(privwin, send_msg);
 
-        plugins_post_priv_message_send(privwin->fulljid, plugin_msg);
+        plugins_post_priv_message_send(privwin->fulljid, send_msg);
         free(plugin_msg);
     }
 }
@@ -46,6 +46,7 @@
 #include "config/scripts.h"
 #include "event/client_events.h"
 #include "plugins/plugins.h"
+#include "tools/matcher.h"
 #include "ui/window_list.h"
 #include "xmpp/muc.h"
 #include "xmpp/chat_session.h"
@@ -216,9 +217,40 @@ sv_ev_room_broadcast(const char *const room_jid, const char *const message)
     }
 }
 
+static void
+_room_history_flush(const char *const room)
+{
+    GList *history = muc_pending_history_take(room);
+    if (history == NULL) {
+        return;
+    }
+
+    ProfMucWin *mucwin = wins_get_muc(room);
+    if (mucwin) {
+        mucwin_history(mucwin, history);
+    }
+    g_list_free_full(history, (GDestroyNotify)muc_history_free);
+}
+
+void
+sv_ev_room_history_check(void)
+{
+    // copies, a plugin called while flushing may leave a later room
+    GList *rooms = muc_pending_history_expired();
+    GList *curr = rooms;
+    while (curr) {
+        _room_history_flush(curr->data);
+        curr = g_list_next(curr);
+    }
+    g_list_free_full(rooms, free);
+}
+
 void
 sv_ev_room_subject(const char *const room, const char *const nick, const char *const subject)
 {
+    // the subject follows the history replayed on join
+    _room_history_flush(room);
+
     muc_set_subject(room, subject);
     ProfMucWin *mucwin = wins_get_muc(room);
     if (mucwin && muc_roster_complete(room)) {
@@ -232,13 +264,199 @@ sv_ev_room_history(const char *const room_jid, const char *const nick,
 {
     ProfMucWin *mucwin = wins_get_muc(room_jid);
     if (mucwin) {
-        mucwin_history(mucwin, nick, timestamp, message);
+        muc_pending_history_add(room_jid, nick, timestamp, message);
+    }
+}
+
+typedef struct room_matcher_t {
+    Matcher matcher;
+    Matcher nick_matcher; // only used when mentions are case sensitive
+    char *nick;
+    gboolean case_sensitive;
+    int triggers_version;
+    GList *triggers;      // trigger n is pattern n
+    int nick_pattern;     // pattern index of the nick in matcher, or -1
+    int nick_len;
+} RoomMatcher;
+
+typedef struct room_matches_t {
+    RoomMatcher *room_matcher;
+    const char *text;
+    gboolean whole_word;
+    gboolean *found_triggers;
+    GSList *mentions;
+} RoomMatches;
+
+// room jid to compiled triggers and own nick
+static GHashTable *room_matchers;
+
+static void
+_room_matcher_free(RoomMatcher *room_matcher)
+{
+    if (room_matcher) {
+        matcher_free(room_matcher->matcher);
+        matcher_free(room_matcher->nick_matcher);
+        free(room_matcher->nick);
+        g_list_free_full(room_matcher->triggers, free);
+        free(room_matcher);
+    }
+}
+
+static RoomMatcher*
+_room_matcher_get(const char *const room, const char *const mynick, gboolean case_sensitive)
+{
+    if (room_matchers == NULL) {
+        room_matchers = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_room_matcher_free);
+    }
+
+    int triggers_version = prefs_get_room_notify_triggers_version();
+    RoomMatcher *room_matcher = g_hash_table_lookup(room_matchers, room);
+    if (room_matcher
+            && g_strcmp0(room_matcher->nick, mynick) == 0
+            && room_matcher->case_sensitive == case_sensitive
+            && room_matcher->triggers_version == triggers_version) {
+        return room_matcher;
+    }
+
+    room_matcher = malloc(sizeof(RoomMatcher));
+    room_matcher->matcher = matcher_new();
+    room_matcher->nick_matcher = NULL;
+    room_matcher->nick = mynick ? strdup(mynick) : NULL;
+    room_matcher->case_sensitive = case_sensitive;
+    room_matcher->triggers_version = triggers_version;
+    room_matcher->triggers = prefs_get_room_notify_triggers();
+    room_matcher->nick_pattern = -1;
+    room_matcher->nick_len = 0;
+
+    // triggers are always case insensitive
+    GList *curr = room_matcher->triggers;
+    while (curr) {
+        char *trigger_lower = g_utf8_strdown(curr->data, -1);
+        matcher_add(room_matcher->matcher, trigger_lower);
+        g_free(trigger_lower);
+        curr = g_list_next(curr);
+    }
+
+    if (mynick && case_sensitive) {
+        room_matcher->nick_matcher = matcher_new();
+        matcher_add(room_matcher->nick_matcher, mynick);
+        matcher_compile(room_matcher->nick_matcher);
+        room_matcher->nick_len = strlen(mynick);
+    } else if (mynick) {
+        char *mynick_lower = g_utf8_strdown(mynick, -1);
+        room_matcher->nick_pattern = matcher_add(room_matcher->matcher, mynick_lower);
+        room_matcher->nick_len = strlen(mynick_lower);
+        g_free(mynick_lower);
+    }
+    matcher_compile(room_matcher->matcher);
+
+    g_hash_table_replace(room_matchers, strdup(room), room_matcher);
+
+    return room_matcher;
+}
+
+void
+sv_ev_room_matcher_remove(const char *const room)
+{
+    if (room_matchers) {
+        g_hash_table_remove(room_matchers, room);
+    }
+}
+
+void
+sv_ev_close(void)
+{
+    if (room_matchers) {
+        g_hash_table_destroy(room_matchers);
+        room_matchers = NULL;
+    }
+}
+
+static gboolean
+_is_whole_word(const char *const text, int offset, int len)
+{
+    if (offset > 0) {
+        gunichar prevu = g_utf8_get_char(g_utf8_prev_char(&text[offset]));
+        if (g_unichar_isalnum(prevu)) {
+            return FALSE;
+        }
+    }
+
+    gunichar nextu = g_utf8_get_char(&text[offset + len]);
+
+    return !g_unichar_isalnum(nextu);
+}
+
+static void
+_room_mention_found(RoomMatches *matches, int offset)
+{
+    if (!matches->whole_word || _is_whole_word(matches->text, offset, matches->room_matcher->nick_len)) {
+        matches->mentions = g_slist_append(matches->mentions, GINT_TO_POINTER(offset));
+    }
+}
+
+static void
+_room_match(int pattern, int offset, void *userdata)
+{
+    RoomMatches *matches = userdata;
+    if (pattern == matches->room_matcher->nick_pattern) {
+        _room_mention_found(matches, offset);
+    } else {
+        matches->found_triggers[pattern] = TRUE;
+    }
+}
+
+static void
+_room_nick_match(int pattern, int offset, void *userdata)
+{
+    _room_mention_found(userdata, offset);
+}
+
+static void
+_room_message_matches(const char *const room, const char *const mynick, const char *const message,
+    GSList **mentions, GList **triggers)
+{
+    gboolean whole_word = prefs_get_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD);
+    gboolean case_sensitive = prefs_get_boolean(PREF_NOTIFY_MENTION_CASE_SENSITIVE);
+    RoomMatcher *room_matcher = _room_matcher_get(room, mynick, case_sensitive);
+
+    char *message_lower = arena_utf8_strdown(connection_stanza_arena(), message);
+    int num_triggers = g_list_length(room_matcher->triggers);
+    gboolean found_triggers[num_triggers + 1];
+    memset(found_triggers, 0, sizeof(found_triggers));
+
+    RoomMatches matches;
+    matches.room_matcher = room_matcher;
+    matches.text = message_lower;
+    matches.whole_word = whole_word;
+    matches.found_triggers = found_triggers;
+    matches.mentions = NULL;
+
+    matcher_scan(room_matcher->matcher, message_lower, _room_match, &matches);
+    if (room_matcher->nick_matcher) {
+        matches.text = message;
+        matcher_scan(room_matcher->nick_matcher, message, _room_nick_match, &matches);
+    }
+
+    *mentions = matches.mentions;
+
+    *triggers = NULL;
+    int i = 0;
+    GList *curr = room_matcher->triggers;
+    while (curr) {
+        if (found_triggers[i]) {
+            *triggers = g_list_append(*triggers, strdup(curr->data));
+        }
+        i++;
+        curr = g_list_next(curr);
     }
 }
 
 void
 sv_ev_room_message(const char *const room_jid, const char *const nick, const char *const message)
 {
+    _room_history_flush(room_jid);
+
     if (prefs_get_boolean(PREF_GRLOG)) {
         Jid *jid = jid_create(connection_get_fulljid());
         groupchat_log_chat(jid->barejid, room_jid, nick, message);
@@ -251,22 +469,15 @@ sv_ev_room_message(const char *const room_jid, const char *const nick, const cha
     }
 
     char *new_message = plugins_pre_room_message_display(room_jid, nick, message);
+    const char *display_message = new_message ? new_message : message;
     char *mynick = muc_nick(mucwin->roomjid);
 
-    gboolean whole_word = prefs_get_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD);
-    gboolean case_sensitive = prefs_get_boolean(PREF_NOTIFY_MENTION_CASE_SENSITIVE);
-    char *message_search = case_sensitive ? strdup(new_message) : g_utf8_strdown(new_message, -1);
-    char *mynick_search = case_sensitive ? strdup(mynick) : g_utf8_strdown(mynick, -1);
-
     GSList *mentions = NULL;
-    mentions = prof_occurrences(mynick_search, message_search, 0, whole_word, &mentions);
-    gboolean mention = g_slist_length(mentions) > 0;
-    g_free(message_search);
-    g_free(mynick_search);
+    GList *triggers = NULL;
+    _room_message_matches(mucwin->roomjid, mynick, display_message, &mentions, &triggers);
+    gboolean mention = mentions != NULL;
 
-    GList *triggers = prefs_message_get_triggers(new_message);
-
-    mucwin_message(mucwin, nick, new_message, mentions, triggers);
+    mucwin_message(mucwin, nick, display_message, mentions, triggers);
 
     g_slist_free(mentions);
 
@@ -303,9 +514,9 @@ sv_ev_room_message(const char *const room_jid, const char *const nick, const cha
         }
     }
 
-    if (prefs_do_room_notify(is_current, mucwin->roomjid, mynick, nick, new_message, mention, triggers != NULL)) {
+    if (prefs_do_room_notify(is_current, mucwin->roomjid, mynick, nick, display_message, mention, triggers != NULL)) {
         Jid *jidp = jid_create(mucwin->roomjid);
-        notify_room_message(nick, jidp->localpart, num, new_message);
+        notify_room_message(nick, jidp->localpart, num, display_message);
         jid_destroy(jidp);
     }
 
@@ -315,7 +526,7 @@ sv_ev_room_message(const char *const room_jid, const char *const nick, const cha
 
     rosterwin_roster();
 
-    plugins_post_room_message_display(room_jid, nick, new_message);
+    plugins_post_room_message_display(room_jid, nick, display_message);
     free(new_message);
 }
 
@@ -323,15 +534,16 @@ void
 sv_ev_incoming_private_message(const char *const fulljid, char *message)
 {
     char *plugin_message =  plugins_pre_priv_message_display(fulljid, message);
+    const char *display_message = plugin_message ? plugin_message : message;
 
     ProfPrivateWin *privatewin = wins_get_private(fulljid);
     if (privatewin == NULL) {
         ProfWin *window = wins_new_private(fulljid);
         privatewin = (ProfPrivateWin*)window;
     }
-    privwin_incoming_msg(privatewin, plugin_message, NULL);
+    privwin_incoming_msg(privatewin, display_message, NULL);
 
-    plugins_post_priv_message_display(fulljid, plugin_message);
+    plugins_post_priv_message_display(fulljid, display_message);
 
     free(plugin_message);
     rosterwin_roster();
@@ -341,19 +553,77 @@ void
 sv_ev_delayed_private_message(const char *const fulljid, char *message, GDateTime *timestamp)
 {
     char *new_message = plugins_pre_priv_message_display(fulljid, message);
+    const char *display_message = new_message ? new_message : message;
 
     ProfPrivateWin *privatewin = wins_get_private(fulljid);
     if (privatewin == NULL) {
         ProfWin *window = wins_new_private(fulljid);
         privatewin = (ProfPrivateWin*)window;
     }
-    privwin_incoming_msg(privatewin, new_message, timestamp);
+    privwin_incoming_msg(privatewin, display_message, timestamp);
 
-    plugins_post_priv_message_display(fulljid, new_message);
+    plugins_post_priv_message_display(fulljid, display_message);
 
     free(new_message);
 }
 
+#ifdef HAVE_LIBGPGME
+// a chat message held back while earlier messages from the same contact are decrypted
+struct pgp_message_t {
+    char *barejid;
+    char *resource;
+    char *message;
+    GDateTime *timestamp;
+    gboolean new_win;
+    gboolean encrypted;
+};
+
+static struct pgp_message_t*
+_pgp_message_new(char *barejid, char *resource, char *message, GDateTime *timestamp, gboolean new_win, gboolean encrypted)
+{
+    struct pgp_message_t *pgp = malloc(sizeof(struct pgp_message_t));
+    pgp->barejid = strdup(barejid);
+    pgp->resource = resource ? strdup(resource) : NULL;
+    pgp->message = message ? strdup(message) : NULL;
+    pgp->timestamp = timestamp ? g_date_time_ref(timestamp) : NULL;
+    pgp->new_win = new_win;
+    pgp->encrypted = encrypted;
+
+    return pgp;
+}
+
+static void
+_pgp_message_free(struct pgp_message_t *pgp)
+{
+    free(pgp->barejid);
+    free(pgp->resource);
+    free(pgp->message);
+    if (pgp->timestamp) {
+        g_date_time_unref(pgp->timestamp);
+    }
+    free(pgp);
+}
+
+static void
+_sv_ev_outgoing_carbon_decrypted(const char *const decrypted, void *userdata)
+{
+    struct pgp_message_t *pgp = userdata;
+
+    ProfChatWin *chatwin = wins_get_chat(pgp->barejid);
+    if (!chatwin) {
+        chatwin = chatwin_new(pgp->barejid);
+    }
+
+    if (decrypted) {
+        chatwin_outgoing_carbon(chatwin, decrypted, PROF_MSG_PGP);
+    } else {
+        chatwin_outgoing_carbon(chatwin, pgp->message, PROF_MSG_PLAIN);
+    }
+
+    _pgp_message_free(pgp);
+}
+#endif
+
 void
 sv_ev_outgoing_carbon(char *barejid, char *message, char *pgp_message)
 {
@@ -366,12 +636,8 @@ sv_ev_outgoing_carbon(char *barejid, char *message, char *pgp_message)
 
 #ifdef HAVE_LIBGPGME
     if (pgp_message) {
-        char *decrypted = p_gpg_decrypt(pgp_message);
-        if (decrypted) {
-            chatwin_outgoing_carbon(chatwin, decrypted, PROF_MSG_PGP);
-        } else {
-            chatwin_outgoing_carbon(chatwin, message, PROF_MSG_PLAIN);
-        }
+        struct pgp_message_t *pgp = _pgp_message_new(barejid, NULL, message, NULL, FALSE, TRUE);
+        p_gpg_decrypt_async(barejid, pgp_message, _sv_ev_outgoing_carbon_decrypted, pgp);
     } else {
         chatwin_outgoing_carbon(chatwin, message, PROF_MSG_PLAIN);
     }
@@ -380,21 +646,53 @@ sv_ev_outgoing_carbon(char *barejid, char *message, char *pgp_message)
 #endif
 }
 
+static void _sv_ev_incoming_plain(ProfChatWin *chatwin, gboolean new_win, char *barejid, char *resource, char *message,
+    GDateTime *timestamp);
+#ifdef HAVE_LIBOTR
+static void _sv_ev_incoming_otr(ProfChatWin *chatwin, gboolean new_win, char *barejid, char *resource, char *message,
+    GDateTime *timestamp);
+#endif
+
 #ifdef HAVE_LIBGPGME
 static void
-_sv_ev_incoming_pgp(ProfChatWin *chatwin, gboolean new_win, char *barejid, char *resource, char *message, char *pgp_message, GDateTime *timestamp)
+_sv_ev_incoming_pgp_decrypted(const char *const decrypted, void *userdata)
 {
-    char *decrypted = p_gpg_decrypt(pgp_message);
-    if (decrypted) {
-        chatwin_incoming_msg(chatwin, resource, decrypted, timestamp, new_win, PROF_MSG_PGP);
-        chat_log_pgp_msg_in(barejid, decrypted, timestamp);
+    struct pgp_message_t *pgp = userdata;
+
+    // the window may have been closed while the message was being decrypted
+    gboolean new_win = pgp->new_win;
+    ProfChatWin *chatwin = wins_get_chat(pgp->barejid);
+    if (!chatwin) {
+        chatwin = (ProfChatWin*)wins_new_chat(pgp->barejid);
+        new_win = TRUE;
+    }
+
+    if (!pgp->encrypted) {
+#ifdef HAVE_LIBOTR
+        _sv_ev_incoming_otr(chatwin, new_win, pgp->barejid, pgp->resource, pgp->message, pgp->timestamp);
+#else
+        _sv_ev_incoming_plain(chatwin, new_win, pgp->barejid, pgp->resource, pgp->message, pgp->timestamp);
+#endif
+    } else if (decrypted) {
+        chatwin_incoming_msg(chatwin, pgp->resource, decrypted, pgp->timestamp, new_win, PROF_MSG_PGP);
+        chat_log_pgp_msg_in(pgp->barejid, decrypted, pgp->timestamp);
         chatwin->pgp_recv = TRUE;
-        p_gpg_free_decrypted(decrypted);
     } else {
-        chatwin_incoming_msg(chatwin, resource, message, timestamp, new_win, PROF_MSG_PLAIN);
-        chat_log_msg_in(barejid, message, timestamp);
+        chatwin_incoming_msg(chatwin, pgp->resource, pgp->message, pgp->timestamp, new_win, PROF_MSG_PLAIN);
+        chat_log_msg_in(pgp->barejid, pgp->message, pgp->timestamp);
         chatwin->pgp_recv = FALSE;
     }
+    rosterwin_roster();
+
+    _pgp_message_free(pgp);
+}
+
+// decrypted in the background, a NULL pgp_message only keeps the message behind earlier ones from the contact
+static void
+_sv_ev_incoming_pgp(ProfChatWin *chatwin, gboolean new_win, char *barejid, char *resource, char *message, char *pgp_message, GDateTime *timestamp)
+{
+    struct pgp_message_t *pgp = _pgp_message_new(barejid, resource, message, timestamp, new_win, pgp_message != NULL);
+    p_gpg_decrypt_async(barejid, pgp_message, _sv_ev_incoming_pgp_decrypted, pgp);
 }
 #endif
 
@@ -446,6 +744,8 @@ sv_ev_incoming_message(char *barejid, char *resource, char *message, char *pgp_m
         } else { // PROF_ENC_NONE, PROF_ENC_PGP
             _sv_ev_incoming_pgp(chatwin, new_win, barejid, resource, message, pgp_message, timestamp);
         }
+    } else if (p_gpg_pending(barejid)) {
+        _sv_ev_incoming_pgp(chatwin, new_win, barejid, resource, message, NULL, timestamp);
     } else {
         _sv_ev_incoming_otr(chatwin, new_win, barejid, resource, message, timestamp);
     }
@@ -466,7 +766,7 @@ sv_ev_incoming_message(char *barejid, char *resource, char *message, char *pgp_m
 // OTR unsupported, PGP supported
 #ifndef HAVE_LIBOTR
 #ifdef HAVE_LIBGPGME
-    if (pgp_message) {
+    if (pgp_message || p_gpg_pending(barejid)) {
         _sv_ev_incoming_pgp(chatwin, new_win, barejid, resource, message, pgp_message, timestamp);
     } else {
         _sv_ev_incoming_plain(chatwin, new_win, barejid, resource, message, timestamp);
@@ -498,7 +798,7 @@ sv_ev_incoming_carbon(char *barejid, char *resource, char *message, char *pgp_me
     }
 
 #ifdef HAVE_LIBGPGME
-    if (pgp_message) {
+    if (pgp_message || p_gpg_pending(barejid)) {
         _sv_ev_incoming_pgp(chatwin, new_win, barejid, resource, message, pgp_message, NULL);
     } else {
         _sv_ev_incoming_plain(chatwin, new_win, barejid, resource, message, NULL);
@@ -651,6 +951,7 @@ void
 sv_ev_leave_room(const char *const room)
 {
     muc_leave(room);
+    sv_ev_room_matcher_remove(room);
     ui_leave_room(room);
 }
 
@@ -658,6 +959,7 @@ void
 sv_ev_room_destroy(const char *const room)
 {
     muc_leave(room);
+    sv_ev_room_matcher_remove(room);
     ui_room_destroy(room);
 }
 
@@ -666,6 +968,7 @@ sv_ev_room_destroyed(const char *const room, const char *const new_jid, const ch
     const char *const reason)
 {
     muc_leave(room);
+    sv_ev_room_matcher_remove(room);
     ui_room_destroyed(room, reason, new_jid, password);
 }
 
@@ -673,6 +976,7 @@ void
 sv_ev_room_kicked(const char *const room, const char *const actor, const char *const reason)
 {
     muc_leave(room);
+    sv_ev_room_matcher_remove(room);
     ui_room_kicked(room, actor, reason);
 }
 
@@ -680,6 +984,7 @@ void
 sv_ev_room_banned(const char *const room, const char *const actor, const char *const reason)
 {
     muc_leave(room);
+    sv_ev_room_matcher_remove(room);
     ui_room_banned(room, actor, reason);
 }
 
@@ -45,6 +45,7 @@ void sv_ev_room_invite(jabber_invite_t invite_type,
     const char *const reason, const char *const password);
 void sv_ev_room_broadcast(const char *const room_jid, const char *const message);
 void sv_ev_room_subject(const char *const room, const char *const nick, const char *const subject);
+void sv_ev_room_history_check(void);
 void sv_ev_room_history(const char *const room_jid, const char *const nick,
     GDateTime *timestamp, const char *const message);
 void sv_ev_room_message(const char *const room_jid, const char *const nick,
@@ -88,5 +89,7 @@ void sv_ev_roster_received(void);
 int sv_ev_certfail(const char *const errormsg, TLSCertificate *cert);
 void sv_ev_lastactivity_response(const char *const from, const int seconds, const char *const msg);
 void sv_ev_bookmark_autojoin(Bookmark *bookmark);
+void sv_ev_room_matcher_remove(const char *const room);
+void sv_ev_close(void);
 
 #endif
@@ -173,9 +173,12 @@ void
 log_close(void)
 {
     g_string_free(mainlogfile, TRUE);
+    mainlogfile = NULL;
     g_time_zone_unref(tz);
+    tz = NULL;
     if (logp) {
         fclose(logp);
+        logp = NULL;
     }
 }
 
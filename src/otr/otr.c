@@ -36,6 +36,7 @@
 #include <libotr/privkey.h>
 #include <libotr/message.h>
 #include <libotr/sm.h>
+#include <pthread.h>
 #include <glib.h>
 
 #include "log.h"
@@ -44,6 +45,7 @@
 #include "otr/otr.h"
 #include "otr/otrlib.h"
 #include "ui/ui.h"
+#include "ui/window.h"
 #include "ui/window_list.h"
 #include "xmpp/chat_session.h"
 #include "xmpp/roster_list.h"
@@ -54,12 +56,36 @@
 #define PRESENCE_OFFLINE 0
 #define PRESENCE_UNKNOWN -1
 
+#define KEYGEN_PROGRESS_INTERVAL 1.0
+
 static OtrlUserState user_state;
 static OtrlMessageAppOps ops;
 static char *jid;
 static gboolean data_loaded;
 static GHashTable *smp_initiators;
 
+// background key generation, the worker thread only touches keygen_newkey,
+// keygen_err and keygen_done, everything else belongs to the main thread
+static gboolean keygen_running;
+static GSList *keygen_queries;
+#if OTRL_VERSION_MAJOR >= 4
+static pthread_t keygen_thread;
+static OtrlUserState keygen_state;
+static OtrlPendingPrivKey *keygen_newkey;
+static char *keygen_account;
+static char *keygen_msg_id;
+static guint keygen_runs;
+static GString *keygen_basedir;
+static GString *keygen_keysfilename;
+static GTimer *keygen_timer;
+static double keygen_last_progress;
+static gcry_error_t keygen_err;
+static volatile gint keygen_done;
+#endif
+
+static void _otr_keygen_check(void);
+static void _otr_keygen_complete(GString *basedir, GString *keysfilename);
+
 OtrlUserState
 otr_userstate(void)
 {
@@ -203,6 +229,7 @@ void
 otr_poll(void)
 {
     otrlib_poll();
+    _otr_keygen_check();
 }
 
 void
@@ -377,6 +404,144 @@ otr_on_message_send(ProfChatWin *chatwin, const char *const message, gboolean re
     return FALSE;
 }
 
+#if OTRL_VERSION_MAJOR >= 4
+static void*
+_otr_keygen_worker(void *userdata)
+{
+    keygen_err = otrl_privkey_generate_calculate(keygen_newkey);
+    g_atomic_int_set(&keygen_done, 1);
+
+    return NULL;
+}
+
+static gboolean
+_otr_keygen_start(const char *const account, GString *basedir, GString *keysfilename)
+{
+    // generate against a private userstate so reconnecting, which replaces
+    // user_state, cannot free the pending key under the worker
+    keygen_state = otrl_userstate_create();
+    if (g_file_test(keysfilename->str, G_FILE_TEST_IS_REGULAR)) {
+        otrl_privkey_read(keygen_state, keysfilename->str);
+    }
+
+    gcry_error_t err = otrl_privkey_generate_start(keygen_state, account, "xmpp", &keygen_newkey);
+    if (err != GPG_ERR_NO_ERROR) {
+        otrl_userstate_free(keygen_state);
+        keygen_state = NULL;
+        return FALSE;
+    }
+
+    g_atomic_int_set(&keygen_done, 0);
+    if (pthread_create(&keygen_thread, NULL, _otr_keygen_worker, NULL) != 0) {
+        otrl_privkey_generate_cancelled(keygen_state, keygen_newkey);
+        otrl_userstate_free(keygen_state);
+        keygen_state = NULL;
+        keygen_newkey = NULL;
+        return FALSE;
+    }
+
+    keygen_account = strdup(account);
+    // a console line per run, create_unique_id restarts on every connect
+    keygen_msg_id = g_strdup_printf("otr-keygen-%u", ++keygen_runs);
+    keygen_basedir = basedir;
+    keygen_keysfilename = keysfilename;
+    keygen_timer = g_timer_new();
+    keygen_last_progress = 0;
+    keygen_running = TRUE;
+
+    ProfWin *console = wins_get_console();
+    win_print_with_receipt(console, '-', 0, NULL, 0, THEME_TEXT, NULL, "Generating private key: 0s elapsed", keygen_msg_id);
+
+    return TRUE;
+}
+
+static void
+_otr_keygen_send_queries(void)
+{
+    GSList *curr = keygen_queries;
+    while (curr) {
+        char *barejid = curr->data;
+        ProfChatWin *chatwin = wins_get_chat(barejid);
+        if (chatwin && !chatwin->is_otr && !chatwin->pgp_send) {
+            char *otr_query_message = otr_start_query();
+            char *id = message_send_chat_otr(barejid, otr_query_message, FALSE);
+            free(id);
+        }
+        curr = g_slist_next(curr);
+    }
+}
+#endif
+
+static void
+_otr_keygen_check(void)
+{
+#if OTRL_VERSION_MAJOR >= 4
+    if (!keygen_running) {
+        return;
+    }
+
+    ProfWin *console = wins_get_console();
+    double elapsed = g_timer_elapsed(keygen_timer, NULL);
+
+    if (!g_atomic_int_get(&keygen_done)) {
+        if (elapsed - keygen_last_progress >= KEYGEN_PROGRESS_INTERVAL) {
+            char *msg = g_strdup_printf("Generating private key: %ds elapsed", (int)elapsed);
+            win_update_entry_message(console, keygen_msg_id, msg);
+            g_free(msg);
+            keygen_last_progress = elapsed;
+        }
+        return;
+    }
+
+    pthread_join(keygen_thread, NULL);
+    keygen_running = FALSE;
+    g_timer_destroy(keygen_timer);
+    keygen_timer = NULL;
+
+    gcry_error_t err = keygen_err;
+    if (err == GPG_ERR_NO_ERROR) {
+        err = otrl_privkey_generate_finish(keygen_state, keygen_newkey, keygen_keysfilename->str);
+    } else {
+        otrl_privkey_generate_cancelled(keygen_state, keygen_newkey);
+    }
+    otrl_userstate_free(keygen_state);
+    keygen_state = NULL;
+    keygen_newkey = NULL;
+
+    char *msg = g_strdup_printf("Generating private key: %ds elapsed", (int)elapsed);
+    win_update_entry_message(console, keygen_msg_id, msg);
+    win_mark_received(console, keygen_msg_id);
+    g_free(msg);
+
+    if (err != GPG_ERR_NO_ERROR) {
+        log_error("Failed to generate private key");
+        cons_show_error("Failed to generate private key");
+        g_string_free(keygen_basedir, TRUE);
+        g_string_free(keygen_keysfilename, TRUE);
+    } else if (connection_get_status() != JABBER_CONNECTED || g_strcmp0(keygen_account, jid) != 0) {
+        // key is on disk, it will be loaded when the account next connects
+        log_info("Private key generated for %s, not currently connected", keygen_account);
+        cons_show("Private key generation complete for %s.", keygen_account);
+        g_string_free(keygen_basedir, TRUE);
+        g_string_free(keygen_keysfilename, TRUE);
+    } else {
+        _otr_keygen_complete(keygen_basedir, keygen_keysfilename);
+        if (data_loaded) {
+            _otr_keygen_send_queries();
+        }
+    }
+
+    free(keygen_account);
+    keygen_account = NULL;
+    g_free(keygen_msg_id);
+    keygen_msg_id = NULL;
+    keygen_basedir = NULL;
+    keygen_keysfilename = NULL;
+    g_slist_free_full(keygen_queries, free);
+    keygen_queries = NULL;
+#endif
+}
+
 void
 otr_keygen(ProfAccount *account)
 {
@@ -385,6 +550,11 @@ otr_keygen(ProfAccount *account)
         return;
     }
 
+    if (keygen_running) {
+        cons_show("OTR key generation already in progress.");
+        return;
+    }
+
     if (jid) {
         free(jid);
     }
@@ -407,15 +577,22 @@ otr_keygen(ProfAccount *account)
         return;
     }
 
-    gcry_error_t err = 0;
-
     GString *keysfilename = g_string_new(basedir->str);
     g_string_append(keysfilename, "keys.txt");
     log_debug("Generating private key file %s for %s", keysfilename->str, jid);
     cons_show("Generating private key, this may take some time.");
     cons_show("Moving the mouse randomly around the screen may speed up the process!");
+
+#if OTRL_VERSION_MAJOR >= 4
+    if (!_otr_keygen_start(account->jid, basedir, keysfilename)) {
+        g_string_free(basedir, TRUE);
+        g_string_free(keysfilename, TRUE);
+        log_error("Failed to generate private key");
+        cons_show_error("Failed to generate private key");
+    }
+#else
     ui_update();
-    err = otrl_privkey_generate(user_state, keysfilename->str, account->jid, "xmpp");
+    gcry_error_t err = otrl_privkey_generate(user_state, keysfilename->str, account->jid, "xmpp");
     if (err != GPG_ERR_NO_ERROR) {
         g_string_free(basedir, TRUE);
         g_string_free(keysfilename, TRUE);
@@ -423,10 +600,33 @@ otr_keygen(ProfAccount *account)
         cons_show_error("Failed to generate private key");
         return;
     }
+    _otr_keygen_complete(basedir, keysfilename);
+#endif
+}
+
+gboolean
+otr_keygen_in_progress(void)
+{
+    return keygen_running;
+}
+
+void
+otr_keygen_queue_start(const char *const barejid)
+{
+    if (g_slist_find_custom(keygen_queries, barejid, (GCompareFunc)g_strcmp0)) {
+        return;
+    }
+    keygen_queries = g_slist_append(keygen_queries, strdup(barejid));
+}
+
+static void
+_otr_keygen_complete(GString *basedir, GString *keysfilename)
+{
     log_info("Private key generated");
     cons_show("");
     cons_show("Private key generation complete.");
 
+    gcry_error_t err = 0;
     GString *fpsfilename = g_string_new(basedir->str);
     g_string_append(fpsfilename, "fingerprints.txt");
     log_debug("Generating fingerprints file %s for %s", fpsfilename->str, jid);
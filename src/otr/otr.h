@@ -75,6 +75,8 @@ char* otr_on_message_recv(const char *const barejid, const char *const resource,
 gboolean otr_on_message_send(ProfChatWin *chatwin, const char *const message, gboolean request_receipt);
 
 void otr_keygen(ProfAccount *account);
+gboolean otr_keygen_in_progress(void);
+void otr_keygen_queue_start(const char *const barejid);
 
 char* otr_tag_message(const char *const msg);
 
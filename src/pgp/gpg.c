@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <pthread.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -48,6 +49,7 @@
 #include "common.h"
 #include "pgp/gpg.h"
 #include "config/files.h"
+#include "config/persist.h"
 #include "tools/autocomplete.h"
 #include "ui/ui.h"
 
@@ -61,12 +63,102 @@ static GHashTable *pubkeys;
 
 static gchar *pubsloc;
 static GKeyFile *pubkeyfile;
+static PersistStore *pubkeys_store;
 
 static char *passphrase;
 static char *passphrase_attempt;
+static char *passphrase_missing;
+static pthread_mutex_t passphrase_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static Autocomplete key_ac;
 
+typedef enum {
+    PGP_CTX_KEYS,
+    PGP_CTX_VERIFY,
+    PGP_CTX_SIGN,
+    PGP_CTX_ENCRYPT,
+    PGP_CTX_DECRYPT,
+    PGP_CTX_DECRYPT_PROMPT,
+    PGP_CTX_COUNT
+} pgp_ctx_t;
+
+// configured once and kept for the session, one per kind of operation
+static gpgme_ctx_t contexts[PGP_CTX_COUNT];
+
+// keys already resolved from the keyring, by key id or fingerprint
+static GHashTable *pubkey_cache;
+static GHashTable *seckey_cache;
+static pthread_mutex_t key_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// presence signatures already verified, to the key id that made them or NULL when unverifiable
+#define VERIFY_CACHE_SIZE 512
+static GHashTable *verify_cache;
+static GQueue *verify_cache_order;
+static gulong verify_cache_hits;
+static gulong verify_cache_misses;
+
+// newest modification time of the public keyring, cached results are dropped when it changes
+static time_t keyring_mtime;
+
+// every key in the keyring by name, built on a background thread and rebuilt when the keyring changes
+static GHashTable *key_index;
+static pthread_mutex_t key_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t key_index_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t key_index_builder;
+static gboolean key_index_started = FALSE;
+static gboolean key_index_building = FALSE;
+static gboolean key_index_rebuild = FALSE;
+static guint key_index_logged = 0;
+static char *key_index_error;
+static guint key_index_generation = 0;
+static gint64 key_index_build_time = 0;
+
+// index generation key_ac was filled from, main thread only
+static guint key_ac_generation = 0;
+
+typedef enum {
+    PGP_JOB_ENCRYPT,
+    PGP_JOB_DECRYPT,
+    PGP_JOB_NONE
+} pgp_job_type_t;
+
+typedef struct pgp_job_t {
+    pgp_job_type_t type;
+    char *barejid;
+    char *input;
+    char *keyid;
+    char *fp;
+    char *result;
+    char *error;
+    char *recipients;
+    gboolean passphrase_needed;
+    ProfPGPCallback callback;
+    void *userdata;
+} ProfPGPJob;
+
+// encryption and decryption run in order on one worker thread, results are handed back in p_gpg_poll
+static pthread_t worker;
+static gboolean worker_started = FALSE;
+static gboolean worker_stop = FALSE;
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobs_cond = PTHREAD_COND_INITIALIZER;
+static GQueue *jobs_todo;
+static GQueue *jobs_done;
+
+// jobs not yet handed back, by contact, main thread only
+static GHashTable *jobs_pending;
+
+static gpgme_error_t _p_gpg_context(pgp_ctx_t type, gpgme_ctx_t *ctx);
+static gpgme_error_t _p_gpg_get_key(gpgme_ctx_t ctx, const char *const id, gpgme_key_t *key, int secret);
+static void _p_gpg_key_cache_clear(void);
+static void _p_gpg_keyring_check(void);
+static time_t _p_gpg_keyring_mtime(void);
+static void _p_gpg_key_index_refresh(void);
+static void _p_gpg_key_index_wait(void);
+static char* _p_gpg_encrypt(const char *const keyid, const char *const message, const char *const fp, char **err);
+static char* _p_gpg_decrypt(pgp_ctx_t type, const char *const cipher, char **err, char **recipients,
+    gboolean *passphrase_needed);
+static void _p_gpg_worker_stop(void);
 static char* _remove_header_footer(char *str, const char *const footer);
 static char* _add_header_footer(const char *const str, const char *const header, const char *const footer);
 static void _save_pubkeys(void);
@@ -83,9 +175,13 @@ _p_gpg_free_pubkeyid(ProfPGPPubKeyId *pubkeyid)
 static gpgme_error_t*
 _p_gpg_passphrase_cb(void *hook, const char *uid_hint, const char *passphrase_info, int prev_was_bad, int fd)
 {
-    if (passphrase) {
+    pthread_mutex_lock(&passphrase_lock);
+    if (passphrase && !prev_was_bad) {
         gpgme_io_write(fd, passphrase, strlen(passphrase));
+        pthread_mutex_unlock(&passphrase_lock);
     } else {
+        pthread_mutex_unlock(&passphrase_lock);
+
         GString *pass_term = g_string_new("");
 
         char *password = ui_ask_pgp_passphrase(uid_hint, prev_was_bad);
@@ -107,6 +203,24 @@ _p_gpg_passphrase_cb(void *hook, const char *uid_hint, const char *passphrase_in
     return 0;
 }
 
+// the worker thread cannot prompt, it only offers a passphrase already entered, a missing one
+// is remembered so p_gpg_poll can ask for it and decrypt the message again
+static gpgme_error_t*
+_p_gpg_cached_passphrase_cb(void *hook, const char *uid_hint, const char *passphrase_info, int prev_was_bad, int fd)
+{
+    pthread_mutex_lock(&passphrase_lock);
+    if (passphrase && !prev_was_bad) {
+        gpgme_io_write(fd, passphrase, strlen(passphrase));
+    } else {
+        free(passphrase_missing);
+        passphrase_missing = strdup(uid_hint ? uid_hint : "key");
+        gpgme_io_write(fd, "\n", 1);
+    }
+    pthread_mutex_unlock(&passphrase_lock);
+
+    return 0;
+}
+
 void
 p_gpg_init(void)
 {
@@ -115,10 +229,15 @@ p_gpg_init(void)
     gpgme_set_locale(NULL, LC_CTYPE, setlocale(LC_CTYPE, NULL));
 
     pubkeys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_p_gpg_free_pubkeyid);
+    pubkey_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)gpgme_key_unref);
+    seckey_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)gpgme_key_unref);
+    verify_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+    verify_cache_order = g_queue_new();
 
     key_ac = autocomplete_new();
-    GHashTable *keys = p_gpg_list_keys();
-    p_gpg_free_keys(keys);
+    key_ac_generation = 0;
+    keyring_mtime = _p_gpg_keyring_mtime();
+    _p_gpg_key_index_refresh();
 
     passphrase = NULL;
     passphrase_attempt = NULL;
@@ -127,11 +246,28 @@ p_gpg_init(void)
 void
 p_gpg_close(void)
 {
+    _p_gpg_worker_stop();
+
+    _p_gpg_key_index_wait();
+    if (key_index_started) {
+        pthread_join(key_index_builder, NULL);
+        key_index_started = FALSE;
+    }
+    if (key_index) {
+        g_hash_table_destroy(key_index);
+        key_index = NULL;
+    }
+    g_free(key_index_error);
+    key_index_error = NULL;
+
     if (pubkeys) {
         g_hash_table_destroy(pubkeys);
         pubkeys = NULL;
     }
 
+    persist_store_free(pubkeys_store);
+    pubkeys_store = NULL;
+
     if (pubkeyfile) {
         g_key_file_free(pubkeyfile);
         pubkeyfile = NULL;
@@ -143,10 +279,34 @@ p_gpg_close(void)
     autocomplete_free(key_ac);
     key_ac = NULL;
 
+    if (pubkey_cache) {
+        g_hash_table_destroy(pubkey_cache);
+        pubkey_cache = NULL;
+    }
+    if (seckey_cache) {
+        g_hash_table_destroy(seckey_cache);
+        seckey_cache = NULL;
+    }
+    if (verify_cache) {
+        g_hash_table_destroy(verify_cache);
+        verify_cache = NULL;
+        g_queue_free(verify_cache_order);
+        verify_cache_order = NULL;
+    }
+
+    int i;
+    for (i = 0; i < PGP_CTX_COUNT; i++) {
+        if (contexts[i]) {
+            gpgme_release(contexts[i]);
+            contexts[i] = NULL;
+        }
+    }
+
     if (passphrase) {
         free(passphrase);
         passphrase = NULL;
     }
+    FREE_SET_NULL(passphrase_missing);
 
     if (passphrase_attempt) {
         free(passphrase_attempt);
@@ -188,13 +348,14 @@ p_gpg_on_connect(const char *const barejid)
 
     pubkeyfile = g_key_file_new();
     g_key_file_load_from_file(pubkeyfile, pubsloc, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    pubkeys_store = persist_store_new(pubkeyfile, pubsloc, PERSIST_DEFAULT_DELAY);
 
     // load each keyid
     gsize len = 0;
     gchar **jids = g_key_file_get_groups(pubkeyfile, &len);
 
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(PGP_CTX_KEYS, &ctx);
 
     if (error) {
         log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
@@ -228,7 +389,6 @@ p_gpg_on_connect(const char *const barejid)
         }
     }
 
-    gpgme_release(ctx);
     g_strfreev(jids);
 
     _save_pubkeys();
@@ -242,6 +402,11 @@ p_gpg_on_disconnect(void)
         pubkeys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_p_gpg_free_pubkeyid);
     }
 
+    _p_gpg_key_cache_clear();
+
+    persist_store_free(pubkeys_store);
+    pubkeys_store = NULL;
+
     if (pubkeyfile) {
         g_key_file_free(pubkeyfile);
         pubkeyfile = NULL;
@@ -250,10 +415,12 @@ p_gpg_on_disconnect(void)
     free(pubsloc);
     pubsloc = NULL;
 
+    pthread_mutex_lock(&passphrase_lock);
     if (passphrase) {
         free(passphrase);
         passphrase = NULL;
     }
+    pthread_mutex_unlock(&passphrase_lock);
 
     if (passphrase_attempt) {
         free(passphrase_attempt);
@@ -265,7 +432,7 @@ gboolean
 p_gpg_addkey(const char *const jid, const char *const keyid)
 {
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(PGP_CTX_KEYS, &ctx);
     if (error) {
         log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return FALSE;
@@ -273,7 +440,6 @@ p_gpg_addkey(const char *const jid, const char *const keyid)
 
     gpgme_key_t key = NULL;
     error = gpgme_get_key(ctx, keyid, &key, 0);
-    gpgme_release(ctx);
 
     if (error || key == NULL) {
         log_error("GPG: Failed to get key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
@@ -321,18 +487,19 @@ _p_gpg_free_key(ProfPGPKey *key)
     }
 }
 
-GHashTable*
-p_gpg_list_keys(void)
+static GHashTable*
+_p_gpg_key_index_build(char **err)
 {
     gpgme_error_t error;
     GHashTable *result = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_p_gpg_free_key);
 
+    // runs on its own thread, so does not share the session contexts
     gpgme_ctx_t ctx;
     error = gpgme_new(&ctx);
 
     if (error) {
-        log_error("GPG: Could not list keys. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        return NULL;
+        *err = g_strdup_printf("GPG: Could not list keys. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        return result;
     }
 
     error = gpgme_op_keylist_start(ctx, NULL, 0);
@@ -391,19 +558,131 @@ p_gpg_list_keys(void)
 
     gpgme_release(ctx);
 
-    autocomplete_clear(key_ac);
-    GList *ids = g_hash_table_get_keys(result);
-    GList *curr = ids;
-    while (curr) {
-        ProfPGPKey *key = g_hash_table_lookup(result, curr->data);
-        autocomplete_add(key_ac, key->id);
-        curr = curr->next;
+    return result;
+}
+
+// builds again while the keyring changed during a build, the result is logged by p_gpg_poll
+static void*
+_p_gpg_key_index_builder(void *userdata)
+{
+    gboolean again = TRUE;
+    while (again) {
+        char *err = NULL;
+        gint64 start = g_get_monotonic_time();
+        GHashTable *index = _p_gpg_key_index_build(&err);
+        gint64 elapsed = g_get_monotonic_time() - start;
+
+        pthread_mutex_lock(&key_index_lock);
+        if (key_index) {
+            g_hash_table_destroy(key_index);
+        }
+        key_index = index;
+        key_index_build_time = elapsed;
+        g_free(key_index_error);
+        key_index_error = err;
+        key_index_generation++;
+
+        again = key_index_rebuild;
+        key_index_rebuild = FALSE;
+        if (!again) {
+            key_index_building = FALSE;
+            pthread_cond_broadcast(&key_index_cond);
+        }
+        pthread_mutex_unlock(&key_index_lock);
+    }
+
+    return NULL;
+}
+
+static void
+_p_gpg_key_index_refresh(void)
+{
+    pthread_mutex_lock(&key_index_lock);
+    if (key_index_building) {
+        key_index_rebuild = TRUE;
+        pthread_mutex_unlock(&key_index_lock);
+        return;
+    }
+    key_index_building = TRUE;
+    pthread_mutex_unlock(&key_index_lock);
+
+    if (key_index_started) {
+        pthread_join(key_index_builder, NULL);
     }
-    g_list_free(ids);
+    pthread_create(&key_index_builder, NULL, &_p_gpg_key_index_builder, NULL);
+    key_index_started = TRUE;
+}
+
+static void
+_p_gpg_key_index_wait(void)
+{
+    pthread_mutex_lock(&key_index_lock);
+    while (key_index_building) {
+        pthread_cond_wait(&key_index_cond, &key_index_lock);
+    }
+    pthread_mutex_unlock(&key_index_lock);
+}
+
+static ProfPGPKey*
+_p_gpg_key_copy(ProfPGPKey *key)
+{
+    ProfPGPKey *copy = _p_gpg_key_new();
+    copy->id = key->id ? strdup(key->id) : NULL;
+    copy->name = key->name ? strdup(key->name) : NULL;
+    copy->fp = key->fp ? strdup(key->fp) : NULL;
+    copy->encrypt = key->encrypt;
+    copy->sign = key->sign;
+    copy->certify = key->certify;
+    copy->authenticate = key->authenticate;
+    copy->secret = key->secret;
+
+    return copy;
+}
+
+GHashTable*
+p_gpg_list_keys(void)
+{
+    // rebuilt only when the keyring has changed, otherwise served from memory
+    _p_gpg_keyring_check();
+    _p_gpg_key_index_wait();
+
+    GHashTable *result = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_p_gpg_free_key);
+
+    pthread_mutex_lock(&key_index_lock);
+    if (key_index) {
+        GHashTableIter iter;
+        gpointer name, key;
+        g_hash_table_iter_init(&iter, key_index);
+        while (g_hash_table_iter_next(&iter, &name, &key)) {
+            g_hash_table_insert(result, strdup(name), _p_gpg_key_copy(key));
+        }
+    }
+    pthread_mutex_unlock(&key_index_lock);
 
     return result;
 }
 
+guint
+p_gpg_key_index_count(void)
+{
+    pthread_mutex_lock(&key_index_lock);
+    guint count = key_index ? g_hash_table_size(key_index) : 0;
+    pthread_mutex_unlock(&key_index_lock);
+
+    return count;
+}
+
+gint64
+p_gpg_key_index_build_time(void)
+{
+    pthread_mutex_lock(&key_index_lock);
+    gint64 build_time = key_index_build_time;
+    pthread_mutex_unlock(&key_index_lock);
+
+    return build_time;
+}
+
+
 void
 p_gpg_free_keys(GHashTable *keys)
 {
@@ -427,7 +706,7 @@ gboolean
 p_gpg_valid_key(const char *const keyid, char **err_str)
 {
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(PGP_CTX_KEYS, &ctx);
     if (error) {
         log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         *err_str = strdup(gpgme_strerror(error));
@@ -440,17 +719,14 @@ p_gpg_valid_key(const char *const keyid, char **err_str)
     if (error || key == NULL) {
         log_error("GPG: Failed to get key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         *err_str = strdup(gpgme_strerror(error));
-        gpgme_release(ctx);
         return FALSE;
     }
 
     if (key == NULL) {
         *err_str = strdup("Unknown error");
-        gpgme_release(ctx);
         return FALSE;
     }
 
-    gpgme_release(ctx);
     gpgme_key_unref(key);
     return TRUE;
 
@@ -463,6 +739,28 @@ p_gpg_available(const char *const barejid)
     return (pubkey != NULL);
 }
 
+static void
+_p_gpg_verified(const char *const barejid, const char *const keyid)
+{
+    ProfPGPPubKeyId *pubkeyid = malloc(sizeof(ProfPGPPubKeyId));
+    pubkeyid->id = strdup(keyid);
+    pubkeyid->received = TRUE;
+    g_hash_table_replace(pubkeys, strdup(barejid), pubkeyid);
+}
+
+static void
+_p_gpg_verify_cache_add(const char *const sign, const char *const keyid)
+{
+    if (g_hash_table_size(verify_cache) >= VERIFY_CACHE_SIZE) {
+        char *oldest = g_queue_pop_head(verify_cache_order);
+        g_hash_table_remove(verify_cache, oldest);
+    }
+
+    char *key = strdup(sign);
+    g_hash_table_replace(verify_cache, key, keyid ? strdup(keyid) : NULL);
+    g_queue_push_tail(verify_cache_order, key);
+}
+
 void
 p_gpg_verify(const char *const barejid, const char *const sign)
 {
@@ -470,8 +768,20 @@ p_gpg_verify(const char *const barejid, const char *const sign)
         return;
     }
 
+    // contacts resend the same signed presence on every reconnect and priority change
+    _p_gpg_keyring_check();
+    char *cached = NULL;
+    if (g_hash_table_lookup_extended(verify_cache, sign, NULL, (gpointer*)&cached)) {
+        verify_cache_hits++;
+        if (cached) {
+            _p_gpg_verified(barejid, cached);
+        }
+        return;
+    }
+    verify_cache_misses++;
+
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(PGP_CTX_VERIFY, &ctx);
 
     if (error) {
         log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
@@ -492,50 +802,59 @@ p_gpg_verify(const char *const barejid, const char *const sign)
 
     if (error) {
         log_error("GPG: Failed to verify. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        _p_gpg_verify_cache_add(sign, NULL);
         return;
     }
 
+    char *keyid = NULL;
     gpgme_verify_result_t result = gpgme_op_verify_result(ctx);
     if (result) {
         if (result->signatures) {
             gpgme_key_t key = NULL;
-            error = gpgme_get_key(ctx, result->signatures->fpr, &key, 0);
+            error = _p_gpg_get_key(ctx, result->signatures->fpr, &key, 0);
             if (error) {
                 log_debug("Could not find PGP key with ID %s for %s", result->signatures->fpr, barejid);
             } else {
                 log_debug("Fingerprint found for %s: %s ", barejid, key->subkeys->fpr);
-                ProfPGPPubKeyId *pubkeyid = malloc(sizeof(ProfPGPPubKeyId));
-                pubkeyid->id = strdup(key->subkeys->keyid);
-                pubkeyid->received = TRUE;
-                g_hash_table_replace(pubkeys, strdup(barejid), pubkeyid);
+                keyid = strdup(key->subkeys->keyid);
+                _p_gpg_verified(barejid, keyid);
             }
 
             gpgme_key_unref(key);
         }
     }
 
-    gpgme_release(ctx);
+    _p_gpg_verify_cache_add(sign, keyid);
+    free(keyid);
+}
+
+gulong
+p_gpg_verify_cache_hits(void)
+{
+    return verify_cache_hits;
+}
+
+gulong
+p_gpg_verify_cache_misses(void)
+{
+    return verify_cache_misses;
 }
 
 char*
 p_gpg_sign(const char *const str, const char *const fp)
 {
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(PGP_CTX_SIGN, &ctx);
     if (error) {
         log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
 
-    gpgme_set_passphrase_cb(ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
-
     gpgme_key_t key = NULL;
-    error = gpgme_get_key(ctx, fp, &key, 1);
+    error = _p_gpg_get_key(ctx, fp, &key, 1);
 
     if (error || key == NULL) {
         log_error("GPG: Failed to get key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
         return NULL;
     }
 
@@ -545,7 +864,6 @@ p_gpg_sign(const char *const str, const char *const fp)
 
     if (error) {
         log_error("GPG: Failed to load signer. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
         return NULL;
     }
 
@@ -562,10 +880,8 @@ p_gpg_sign(const char *const str, const char *const fp)
     gpgme_data_t signed_data;
     gpgme_data_new(&signed_data);
 
-    gpgme_set_armor(ctx,1);
     error = gpgme_op_sign(ctx, str_data, signed_data, GPGME_SIG_MODE_DETACH);
     gpgme_data_release(str_data);
-    gpgme_release(ctx);
 
     if (error) {
         log_error("GPG: Failed to sign string. %s %s", gpgme_strsource(error), gpgme_strerror(error));
@@ -586,20 +902,20 @@ p_gpg_sign(const char *const str, const char *const fp)
     }
 
     if (passphrase_attempt) {
+        pthread_mutex_lock(&passphrase_lock);
+        free(passphrase);
         passphrase = strdup(passphrase_attempt);
+        pthread_mutex_unlock(&passphrase_lock);
     }
 
     return result;
 }
 
-char*
-p_gpg_encrypt(const char *const barejid, const char *const message, const char *const fp)
+// runs on the worker thread, errors are returned in err for the main thread to log
+static char*
+_p_gpg_encrypt(const char *const keyid, const char *const message, const char *const fp, char **err)
 {
-    ProfPGPPubKeyId *pubkeyid = g_hash_table_lookup(pubkeys, barejid);
-    if (!pubkeyid) {
-        return NULL;
-    }
-    if (!pubkeyid->id) {
+    if (!keyid) {
         return NULL;
     }
 
@@ -610,26 +926,25 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
     keys[2] = NULL;
 
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(PGP_CTX_ENCRYPT, &ctx);
     if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err = g_strdup_printf("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
 
     gpgme_key_t receiver_key;
-    error = gpgme_get_key(ctx, pubkeyid->id, &receiver_key, 0);
+    error = _p_gpg_get_key(ctx, keyid, &receiver_key, 0);
     if (error || receiver_key == NULL) {
-        log_error("GPG: Failed to get receiver_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        *err = g_strdup_printf("GPG: Failed to get receiver_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
     keys[0] = receiver_key;
 
     gpgme_key_t sender_key = NULL;
-    error = gpgme_get_key(ctx, fp, &sender_key, 0);
+    error = _p_gpg_get_key(ctx, fp, &sender_key, 0);
     if (error || sender_key == NULL) {
-        log_error("GPG: Failed to get sender_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        *err = g_strdup_printf("GPG: Failed to get sender_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        gpgme_key_unref(receiver_key);
         return NULL;
     }
     keys[1] = sender_key;
@@ -640,15 +955,13 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
     gpgme_data_t cipher;
     gpgme_data_new(&cipher);
 
-    gpgme_set_armor(ctx, 1);
     error = gpgme_op_encrypt(ctx, keys, GPGME_ENCRYPT_ALWAYS_TRUST, plain, cipher);
     gpgme_data_release(plain);
-    gpgme_release(ctx);
     gpgme_key_unref(receiver_key);
     gpgme_key_unref(sender_key);
 
     if (error) {
-        log_error("GPG: Failed to encrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err = g_strdup_printf("GPG: Failed to encrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
 
@@ -667,19 +980,19 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
     return result;
 }
 
-char*
-p_gpg_decrypt(const char *const cipher)
+// runs on the worker thread, errors and recipients are returned for the main thread to log
+static char*
+_p_gpg_decrypt(pgp_ctx_t type, const char *const cipher, char **err, char **recipients,
+    gboolean *passphrase_needed)
 {
     gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+    gpgme_error_t error = _p_gpg_context(type, &ctx);
 
     if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err = g_strdup_printf("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
 
-    gpgme_set_passphrase_cb(ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
-
     char *cipher_with_headers = _add_header_footer(cipher, PGP_MESSAGE_HEADER, PGP_MESSAGE_FOOTER);
     gpgme_data_t cipher_data;
     gpgme_data_new_from_mem(&cipher_data, cipher_with_headers, strlen(cipher_with_headers), 1);
@@ -692,9 +1005,19 @@ p_gpg_decrypt(const char *const cipher)
     gpgme_data_release(cipher_data);
 
     if (error) {
-        log_error("GPG: Failed to encrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        pthread_mutex_lock(&passphrase_lock);
+        if (passphrase_missing) {
+            *err = g_strdup_printf("GPG: No passphrase available for %s, failed to decrypt message. %s %s",
+                passphrase_missing, gpgme_strsource(error), gpgme_strerror(error));
+            FREE_SET_NULL(passphrase_missing);
+            if (passphrase_needed) {
+                *passphrase_needed = TRUE;
+            }
+        } else {
+            *err = g_strdup_printf("GPG: Failed to decrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        }
+        pthread_mutex_unlock(&passphrase_lock);
         gpgme_data_release(plain_data);
-        gpgme_release(ctx);
         return NULL;
     }
 
@@ -704,7 +1027,7 @@ p_gpg_decrypt(const char *const cipher)
         gpgme_recipient_t recipient = res->recipients;
         while (recipient) {
             gpgme_key_t key;
-            error = gpgme_get_key(ctx, recipient->keyid, &key, 1);
+            error = _p_gpg_get_key(ctx, recipient->keyid, &key, 1);
 
             if (!error && key) {
                 const char *addr = gpgme_key_get_string_attr(key, GPGME_ATTR_EMAIL, NULL, 0);
@@ -721,36 +1044,266 @@ p_gpg_decrypt(const char *const cipher)
             recipient = recipient->next;
         }
 
-        log_debug("GPG: Decrypted message for recipients: %s", recipients_str->str);
-        g_string_free(recipients_str, TRUE);
+        *recipients = g_string_free(recipients_str, FALSE);
     }
-    gpgme_release(ctx);
 
     size_t len = 0;
     char *plain_str = gpgme_data_release_and_get_mem(plain_data, &len);
     char *result = NULL;
     if (plain_str) {
         plain_str[len] = 0;
-        result = g_strdup(plain_str);
+        result = strdup(plain_str);
     }
     gpgme_free(plain_str);
 
-    if (passphrase_attempt) {
-        passphrase = strdup(passphrase_attempt);
+    return result;
+}
+
+static void
+_p_gpg_free_job(ProfPGPJob *job)
+{
+    free(job->barejid);
+    free(job->input);
+    free(job->keyid);
+    free(job->fp);
+    free(job->result);
+    g_free(job->error);
+    g_free(job->recipients);
+    free(job);
+}
+
+static void*
+_p_gpg_worker(void *userdata)
+{
+    pthread_mutex_lock(&jobs_lock);
+    while (!worker_stop) {
+        if (g_queue_is_empty(jobs_todo)) {
+            pthread_cond_wait(&jobs_cond, &jobs_lock);
+            continue;
+        }
+        ProfPGPJob *job = g_queue_peek_head(jobs_todo);
+        pthread_mutex_unlock(&jobs_lock);
+
+        switch (job->type) {
+        case PGP_JOB_ENCRYPT:
+            job->result = _p_gpg_encrypt(job->keyid, job->input, job->fp, &job->error);
+            break;
+        case PGP_JOB_DECRYPT:
+            job->result = _p_gpg_decrypt(PGP_CTX_DECRYPT, job->input, &job->error, &job->recipients,
+                &job->passphrase_needed);
+            break;
+        default:
+            break;
+        }
+
+        pthread_mutex_lock(&jobs_lock);
+        g_queue_pop_head(jobs_todo);
+        g_queue_push_tail(jobs_done, job);
     }
+    pthread_mutex_unlock(&jobs_lock);
 
-    return result;
+    return NULL;
+}
+
+static void
+_p_gpg_submit(ProfPGPJob *job)
+{
+    if (!jobs_pending) {
+        jobs_pending = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    }
+    int pending = GPOINTER_TO_INT(g_hash_table_lookup(jobs_pending, job->barejid));
+    g_hash_table_replace(jobs_pending, strdup(job->barejid), GINT_TO_POINTER(pending + 1));
+
+    pthread_mutex_lock(&jobs_lock);
+    if (!worker_started) {
+        jobs_todo = g_queue_new();
+        jobs_done = g_queue_new();
+        worker_stop = FALSE;
+        pthread_create(&worker, NULL, &_p_gpg_worker, NULL);
+        worker_started = TRUE;
+    }
+    g_queue_push_tail(jobs_todo, job);
+    pthread_cond_signal(&jobs_cond);
+    pthread_mutex_unlock(&jobs_lock);
+}
+
+static void
+_p_gpg_worker_stop(void)
+{
+    pthread_mutex_lock(&jobs_lock);
+    if (!worker_started) {
+        pthread_mutex_unlock(&jobs_lock);
+        return;
+    }
+    worker_stop = TRUE;
+    pthread_cond_signal(&jobs_cond);
+    pthread_mutex_unlock(&jobs_lock);
+
+    pthread_join(worker, NULL);
+    worker_started = FALSE;
+
+    // results nobody will collect any more
+    ProfPGPJob *job;
+    while ((job = g_queue_pop_head(jobs_todo))) {
+        _p_gpg_free_job(job);
+    }
+    while ((job = g_queue_pop_head(jobs_done))) {
+        _p_gpg_free_job(job);
+    }
+    g_queue_free(jobs_todo);
+    g_queue_free(jobs_done);
+    jobs_todo = NULL;
+    jobs_done = NULL;
+
+    if (jobs_pending) {
+        g_hash_table_destroy(jobs_pending);
+        jobs_pending = NULL;
+    }
 }
 
 void
-p_gpg_free_decrypted(char *decrypted)
+p_gpg_encrypt_async(const char *const barejid, const char *const message, const char *const fp,
+    ProfPGPCallback callback, void *userdata)
 {
-    g_free(decrypted);
+    ProfPGPJob *job = calloc(1, sizeof(ProfPGPJob));
+    job->type = PGP_JOB_ENCRYPT;
+    job->barejid = strdup(barejid);
+    job->input = strdup(message);
+    job->fp = strdup(fp);
+    job->callback = callback;
+    job->userdata = userdata;
+
+    _p_gpg_keyring_check();
+
+    // resolved here, the worker never reads the contact key list
+    ProfPGPPubKeyId *pubkeyid = g_hash_table_lookup(pubkeys, barejid);
+    if (pubkeyid && pubkeyid->id) {
+        job->keyid = strdup(pubkeyid->id);
+    }
+
+    _p_gpg_submit(job);
+}
+
+void
+p_gpg_decrypt_async(const char *const barejid, const char *const cipher, ProfPGPCallback callback, void *userdata)
+{
+    ProfPGPJob *job = calloc(1, sizeof(ProfPGPJob));
+    job->type = cipher ? PGP_JOB_DECRYPT : PGP_JOB_NONE;
+    job->barejid = strdup(barejid);
+    job->input = cipher ? strdup(cipher) : NULL;
+    job->callback = callback;
+    job->userdata = userdata;
+
+    _p_gpg_submit(job);
+}
+
+gboolean
+p_gpg_pending(const char *const barejid)
+{
+    return jobs_pending && g_hash_table_lookup(jobs_pending, barejid) != NULL;
+}
+
+static void
+_p_gpg_key_index_log(void)
+{
+    pthread_mutex_lock(&key_index_lock);
+    if (key_index_logged == key_index_generation) {
+        pthread_mutex_unlock(&key_index_lock);
+        return;
+    }
+    key_index_logged = key_index_generation;
+    guint count = key_index ? g_hash_table_size(key_index) : 0;
+    gint64 elapsed = key_index_build_time;
+    char *err = key_index_error;
+    key_index_error = NULL;
+    pthread_mutex_unlock(&key_index_lock);
+
+    if (err) {
+        log_error("%s", err);
+        g_free(err);
+    }
+    log_info("GPG: Indexed %u keys in %ldms", count, (long)(elapsed / 1000));
+}
+
+static void
+_p_gpg_decrypt_prompt(ProfPGPJob *job)
+{
+    g_free(job->error);
+    job->error = NULL;
+    g_free(job->recipients);
+    job->recipients = NULL;
+
+    job->result = _p_gpg_decrypt(PGP_CTX_DECRYPT_PROMPT, job->input, &job->error, &job->recipients, NULL);
+
+    if (job->result && passphrase_attempt) {
+        pthread_mutex_lock(&passphrase_lock);
+        free(passphrase);
+        passphrase = strdup(passphrase_attempt);
+        pthread_mutex_unlock(&passphrase_lock);
+    }
+}
+
+void
+p_gpg_poll(void)
+{
+    _p_gpg_key_index_log();
+
+    if (!worker_started) {
+        return;
+    }
+
+    GQueue *done = g_queue_new();
+    ProfPGPJob *job;
+    pthread_mutex_lock(&jobs_lock);
+    while ((job = g_queue_pop_head(jobs_done))) {
+        g_queue_push_tail(done, job);
+    }
+    pthread_mutex_unlock(&jobs_lock);
+
+    while ((job = g_queue_pop_head(done))) {
+
+        // asked for here and decrypted again on this thread, later jobs use the cached passphrase
+        if (job->passphrase_needed) {
+            _p_gpg_decrypt_prompt(job);
+        }
+
+        int pending = GPOINTER_TO_INT(g_hash_table_lookup(jobs_pending, job->barejid));
+        if (pending > 1) {
+            g_hash_table_replace(jobs_pending, strdup(job->barejid), GINT_TO_POINTER(pending - 1));
+        } else {
+            g_hash_table_remove(jobs_pending, job->barejid);
+        }
+
+        if (job->error) {
+            log_error("%s", job->error);
+        }
+        if (job->recipients) {
+            log_debug("GPG: Decrypted message for recipients: %s", job->recipients);
+        }
+
+        job->callback(job->result, job->userdata);
+        _p_gpg_free_job(job);
+    }
+    g_queue_free(done);
 }
 
 char*
 p_gpg_autocomplete_key(const char *const search_str)
 {
+    // refill from the index only after it has been rebuilt
+    pthread_mutex_lock(&key_index_lock);
+    if (key_index && key_ac_generation != key_index_generation) {
+        autocomplete_clear(key_ac);
+        GHashTableIter iter;
+        gpointer name, key;
+        g_hash_table_iter_init(&iter, key_index);
+        while (g_hash_table_iter_next(&iter, &name, &key)) {
+            autocomplete_add(key_ac, ((ProfPGPKey*)key)->id);
+        }
+        key_ac_generation = key_index_generation;
+    }
+    pthread_mutex_unlock(&key_index_lock);
+
     return autocomplete_complete(key_ac, search_str, TRUE);
 }
 
@@ -783,6 +1336,137 @@ p_gpg_format_fp_str(char *fp)
     return result;
 }
 
+static gpgme_error_t
+_p_gpg_context(pgp_ctx_t type, gpgme_ctx_t *ctx)
+{
+    if (contexts[type]) {
+        *ctx = contexts[type];
+        return GPG_ERR_NO_ERROR;
+    }
+
+    gpgme_error_t error = gpgme_new(ctx);
+    if (error) {
+        return error;
+    }
+
+    switch (type) {
+    case PGP_CTX_SIGN:
+        gpgme_set_passphrase_cb(*ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
+        gpgme_set_armor(*ctx, 1);
+        break;
+    case PGP_CTX_ENCRYPT:
+        gpgme_set_armor(*ctx, 1);
+        break;
+    case PGP_CTX_DECRYPT:
+        gpgme_set_passphrase_cb(*ctx, (gpgme_passphrase_cb_t)_p_gpg_cached_passphrase_cb, NULL);
+        break;
+    case PGP_CTX_DECRYPT_PROMPT:
+        gpgme_set_passphrase_cb(*ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
+        break;
+    default:
+        break;
+    }
+
+    contexts[type] = *ctx;
+    return GPG_ERR_NO_ERROR;
+}
+
+// keys are looked up in the keyring once, the caller owns a reference to the returned key
+static gpgme_error_t
+_p_gpg_get_key(gpgme_ctx_t ctx, const char *const id, gpgme_key_t *key, int secret)
+{
+    GHashTable *cache = secret ? seckey_cache : pubkey_cache;
+
+    pthread_mutex_lock(&key_cache_lock);
+    gpgme_key_t cached = g_hash_table_lookup(cache, id);
+    if (cached) {
+        gpgme_key_ref(cached);
+        *key = cached;
+        pthread_mutex_unlock(&key_cache_lock);
+        return GPG_ERR_NO_ERROR;
+    }
+    pthread_mutex_unlock(&key_cache_lock);
+
+    gpgme_error_t error = gpgme_get_key(ctx, id, key, secret);
+    if (!error && *key) {
+        gpgme_key_ref(*key);
+        pthread_mutex_lock(&key_cache_lock);
+        g_hash_table_replace(cache, strdup(id), *key);
+        pthread_mutex_unlock(&key_cache_lock);
+    }
+
+    return error;
+}
+
+static void
+_p_gpg_key_cache_clear(void)
+{
+    pthread_mutex_lock(&key_cache_lock);
+    if (pubkey_cache) {
+        g_hash_table_remove_all(pubkey_cache);
+    }
+    if (seckey_cache) {
+        g_hash_table_remove_all(seckey_cache);
+    }
+    pthread_mutex_unlock(&key_cache_lock);
+
+    if (verify_cache) {
+        g_hash_table_remove_all(verify_cache);
+        g_queue_clear(verify_cache_order);
+    }
+}
+
+static time_t
+_p_gpg_keyring_mtime(void)
+{
+    const char *home = NULL;
+    gpgme_engine_info_t info = NULL;
+    if (gpgme_get_engine_info(&info) == GPG_ERR_NO_ERROR) {
+        while (info && info->protocol != GPGME_PROTOCOL_OpenPGP) {
+            info = info->next;
+        }
+        if (info) {
+            home = info->home_dir;
+        }
+    }
+
+    gchar *homedir = NULL;
+    if (home) {
+        homedir = g_strdup(home);
+    } else if (getenv("GNUPGHOME")) {
+        homedir = g_strdup(getenv("GNUPGHOME"));
+    } else {
+        homedir = g_build_filename(g_get_home_dir(), ".gnupg", NULL);
+    }
+
+    // gnupg 2.1 uses a keybox, older versions a keyring
+    time_t mtime = 0;
+    const char *keyrings[] = { "pubring.kbx", "pubring.gpg" };
+    int i;
+    for (i = 0; i < 2; i++) {
+        gchar *path = g_build_filename(homedir, keyrings[i], NULL);
+        struct stat st;
+        if (stat(path, &st) == 0 && st.st_mtime > mtime) {
+            mtime = st.st_mtime;
+        }
+        g_free(path);
+    }
+    g_free(homedir);
+
+    return mtime;
+}
+
+static void
+_p_gpg_keyring_check(void)
+{
+    time_t mtime = _p_gpg_keyring_mtime();
+    if (mtime != keyring_mtime) {
+        keyring_mtime = mtime;
+        _p_gpg_key_cache_clear();
+        _p_gpg_key_index_refresh();
+    }
+}
+
 static char*
 _remove_header_footer(char *str, const char *const footer)
 {
@@ -827,9 +1511,5 @@ _add_header_footer(const char *const str, const char *const header, const char *
 static void
 _save_pubkeys(void)
 {
-    gsize g_data_size;
-    gchar *g_pubkeys_data = g_key_file_to_data(pubkeyfile, &g_data_size, NULL);
-    g_file_set_contents(pubsloc, g_pubkeys_data, g_data_size, NULL);
-    g_chmod(pubsloc, S_IRUSR | S_IWUSR);
-    g_free(g_pubkeys_data);
+    persist_store_mark_dirty(pubkeys_store);
 }
@@ -51,11 +51,16 @@ typedef struct pgp_pubkeyid_t {
     gboolean received;
 } ProfPGPPubKeyId;
 
+// called on the main thread with the result of a background operation, NULL if it failed
+typedef void (*ProfPGPCallback)(const char *const result, void *userdata);
+
 void p_gpg_init(void);
 void p_gpg_close(void);
 void p_gpg_on_connect(const char *const barejid);
 void p_gpg_on_disconnect(void);
 GHashTable* p_gpg_list_keys(void);
+guint p_gpg_key_index_count(void);
+gint64 p_gpg_key_index_build_time(void);
 void p_gpg_free_keys(GHashTable *keys);
 gboolean p_gpg_addkey(const char *const jid, const char *const keyid);
 GHashTable* p_gpg_pubkeys(void);
@@ -64,9 +69,13 @@ gboolean p_gpg_available(const char *const barejid);
 const char* p_gpg_libver(void);
 char* p_gpg_sign(const char *const str, const char *const fp);
 void p_gpg_verify(const char *const barejid, const char *const sign);
-char* p_gpg_encrypt(const char *const barejid, const char *const message, const char *const fp);
-char* p_gpg_decrypt(const char *const cipher);
-void p_gpg_free_decrypted(char *decrypted);
+gulong p_gpg_verify_cache_hits(void);
+gulong p_gpg_verify_cache_misses(void);
+void p_gpg_encrypt_async(const char *const barejid, const char *const message, const char *const fp,
+    ProfPGPCallback callback, void *userdata);
+void p_gpg_decrypt_async(const char *const barejid, const char *const cipher, ProfPGPCallback callback, void *userdata);
+gboolean p_gpg_pending(const char *const barejid);
+void p_gpg_poll(void);
 char* p_gpg_autocomplete_key(const char *const search_str);
 void p_gpg_autocomplete_key_reset(void);
 char* p_gpg_format_fp_str(char *fp);
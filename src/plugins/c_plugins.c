@@ -50,6 +50,12 @@
 #include "plugins/c_api.h"
 #include "ui/ui.h"
 
+static gboolean
+_c_has_func(void *handle, const char *const name)
+{
+    return dlsym(handle, name) != NULL;
+}
+
 void
 c_env_init(void)
 {
@@ -81,34 +87,34 @@ c_plugin_create(const char *const filename)
     plugin->lang = LANG_C;
     plugin->module = handle;
     plugin->init_func = c_init_hook;
-    plugin->on_start_func = c_on_start_hook;
-    plugin->on_shutdown_func = c_on_shutdown_hook;
-    plugin->on_unload_func = c_on_unload_hook;
-    plugin->on_connect_func = c_on_connect_hook;
-    plugin->on_disconnect_func = c_on_disconnect_hook;
-    plugin->pre_chat_message_display = c_pre_chat_message_display_hook;
-    plugin->post_chat_message_display = c_post_chat_message_display_hook;
-    plugin->pre_chat_message_send = c_pre_chat_message_send_hook;
-    plugin->post_chat_message_send = c_post_chat_message_send_hook;
-    plugin->pre_room_message_display = c_pre_room_message_display_hook;
-    plugin->post_room_message_display = c_post_room_message_display_hook;
-    plugin->pre_room_message_send = c_pre_room_message_send_hook;
-    plugin->post_room_message_send = c_post_room_message_send_hook;
-    plugin->on_room_history_message = c_on_room_history_message_hook;
-    plugin->pre_priv_message_display = c_pre_priv_message_display_hook;
-    plugin->post_priv_message_display = c_post_priv_message_display_hook;
-    plugin->pre_priv_message_send = c_pre_priv_message_send_hook;
-    plugin->post_priv_message_send = c_post_priv_message_send_hook;
-    plugin->on_message_stanza_send = c_on_message_stanza_send_hook;
-    plugin->on_message_stanza_receive = c_on_message_stanza_receive_hook;
-    plugin->on_presence_stanza_send = c_on_presence_stanza_send_hook;
-    plugin->on_presence_stanza_receive = c_on_presence_stanza_receive_hook;
-    plugin->on_iq_stanza_send = c_on_iq_stanza_send_hook;
-    plugin->on_iq_stanza_receive = c_on_iq_stanza_receive_hook;
-    plugin->on_contact_offline = c_on_contact_offline_hook;
-    plugin->on_contact_presence = c_on_contact_presence_hook;
-    plugin->on_chat_win_focus = c_on_chat_win_focus_hook;
-    plugin->on_room_win_focus = c_on_room_win_focus_hook;
+    plugin->on_start_func = _c_has_func(handle, "prof_on_start") ? c_on_start_hook : NULL;
+    plugin->on_shutdown_func = _c_has_func(handle, "prof_on_shutdown") ? c_on_shutdown_hook : NULL;
+    plugin->on_unload_func = _c_has_func(handle, "prof_on_unload") ? c_on_unload_hook : NULL;
+    plugin->on_connect_func = _c_has_func(handle, "prof_on_connect") ? c_on_connect_hook : NULL;
+    plugin->on_disconnect_func = _c_has_func(handle, "prof_on_disconnect") ? c_on_disconnect_hook : NULL;
+    plugin->pre_chat_message_display = _c_has_func(handle, "prof_pre_chat_message_display") ? c_pre_chat_message_display_hook : NULL;
+    plugin->post_chat_message_display = _c_has_func(handle, "prof_post_chat_message_display") ? c_post_chat_message_display_hook : NULL;
+    plugin->pre_chat_message_send = _c_has_func(handle, "prof_pre_chat_message_send") ? c_pre_chat_message_send_hook : NULL;
+    plugin->post_chat_message_send = _c_has_func(handle, "prof_post_chat_message_send") ? c_post_chat_message_send_hook : NULL;
+    plugin->pre_room_message_display = _c_has_func(handle, "prof_pre_room_message_display") ? c_pre_room_message_display_hook : NULL;
+    plugin->post_room_message_display = _c_has_func(handle, "prof_post_room_message_display") ? c_post_room_message_display_hook : NULL;
+    plugin->pre_room_message_send = _c_has_func(handle, "prof_pre_room_message_send") ? c_pre_room_message_send_hook : NULL;
+    plugin->post_room_message_send = _c_has_func(handle, "prof_post_room_message_send") ? c_post_room_message_send_hook : NULL;
+    plugin->on_room_history_message = _c_has_func(handle, "prof_on_room_history_message") ? c_on_room_history_message_hook : NULL;
+    plugin->pre_priv_message_display = _c_has_func(handle, "prof_pre_priv_message_display") ? c_pre_priv_message_display_hook : NULL;
+    plugin->post_priv_message_display = _c_has_func(handle, "prof_post_priv_message_display") ? c_post_priv_message_display_hook : NULL;
+    plugin->pre_priv_message_send = _c_has_func(handle, "prof_pre_priv_message_send") ? c_pre_priv_message_send_hook : NULL;
+    plugin->post_priv_message_send = _c_has_func(handle, "prof_post_priv_message_send") ? c_post_priv_message_send_hook : NULL;
+    plugin->on_message_stanza_send = _c_has_func(handle, "prof_on_message_stanza_send") ? c_on_message_stanza_send_hook : NULL;
+    plugin->on_message_stanza_receive = _c_has_func(handle, "prof_on_message_stanza_receive") ? c_on_message_stanza_receive_hook : NULL;
+    plugin->on_presence_stanza_send = _c_has_func(handle, "prof_on_presence_stanza_send") ? c_on_presence_stanza_send_hook : NULL;
+    plugin->on_presence_stanza_receive = _c_has_func(handle, "prof_on_presence_stanza_receive") ? c_on_presence_stanza_receive_hook : NULL;
+    plugin->on_iq_stanza_send = _c_has_func(handle, "prof_on_iq_stanza_send") ? c_on_iq_stanza_send_hook : NULL;
+    plugin->on_iq_stanza_receive = _c_has_func(handle, "prof_on_iq_stanza_receive") ? c_on_iq_stanza_receive_hook : NULL;
+    plugin->on_contact_offline = _c_has_func(handle, "prof_on_contact_offline") ? c_on_contact_offline_hook : NULL;
+    plugin->on_contact_presence = _c_has_func(handle, "prof_on_contact_presence") ? c_on_contact_presence_hook : NULL;
+    plugin->on_chat_win_focus = _c_has_func(handle, "prof_on_chat_win_focus") ? c_on_chat_win_focus_hook : NULL;
+    plugin->on_room_win_focus = _c_has_func(handle, "prof_on_room_win_focus") ? c_on_room_win_focus_hook : NULL;
 
     g_string_free(path, TRUE);
 
@@ -50,6 +50,7 @@
 #include "plugins/disco.h"
 #include "ui/ui.h"
 #include "xmpp/xmpp.h"
+#include "xmpp/muc.h"
 
 #ifdef HAVE_PYTHON
 #include "plugins/python_plugins.h"
@@ -62,6 +63,9 @@
 #endif
 
 static GHashTable *plugins;
+static GList *subscribers[HOOK_COUNT];
+
+static void _plugins_update_subscribers(void);
 
 void
 plugins_init(void)
@@ -112,6 +116,8 @@ plugins_init(void)
             }
         }
 
+        _plugins_update_subscribers();
+
         // initialise plugins
         GList *values = g_hash_table_get_values(plugins);
         GList *curr = values;
@@ -174,6 +180,7 @@ plugins_load(const char *const name)
 #endif
     if (plugin) {
         g_hash_table_insert(plugins, strdup(name), plugin);
+        _plugins_update_subscribers();
         if (connection_get_status() == JABBER_CONNECTED) {
             const char *account_name = session_get_account_name();
             const char *fulljid = connection_get_fulljid();
@@ -195,7 +202,9 @@ plugins_unload(const char *const name)
 {
     ProfPlugin *plugin = g_hash_table_lookup(plugins, name);
     if (plugin) {
-        plugin->on_unload_func(plugin);
+        if (plugin->on_unload_func) {
+            plugin->on_unload_func(plugin);
+        }
 #ifdef HAVE_PYTHON
         if (plugin->lang == LANG_PYTHON) {
             python_plugin_destroy(plugin);
@@ -208,6 +217,7 @@ plugins_unload(const char *const name)
 #endif
         prefs_remove_plugin(name);
         g_hash_table_remove(plugins, name);
+        _plugins_update_subscribers();
 
         caps_reset_ver();
         // resend presence to update server's disco info data for this client
@@ -289,6 +299,12 @@ plugins_loaded_list(void)
     return g_hash_table_get_keys(plugins);
 }
 
+gboolean
+plugins_has_hook(plugin_hook_t hook)
+{
+    return subscribers[hook] != NULL;
+}
+
 char *
 plugins_autocomplete(const char * const input)
 {
@@ -319,74 +335,67 @@ plugins_close_win(const char *const plugin_name, const char *const tag)
 void
 plugins_on_start(void)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_START];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_start_func(plugin);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_shutdown(void)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_SHUTDOWN];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_shutdown_func(plugin);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_connect(const char * const account_name, const char * const fulljid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_CONNECT];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_connect_func(plugin, account_name, fulljid);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_disconnect(const char * const account_name, const char * const fulljid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_DISCONNECT];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_disconnect_func(plugin, account_name, fulljid);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_chat_message_display(const char * const barejid, const char *const resource, const char *message)
 {
+    GList *curr = subscribers[HOOK_PRE_CHAT_MESSAGE_DISPLAY];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_message = plugin->pre_chat_message_display(plugin, barejid, resource, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -394,35 +403,34 @@ plugins_pre_chat_message_display(const char * const barejid, const char *const r
 void
 plugins_post_chat_message_display(const char * const barejid, const char *const resource, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_POST_CHAT_MESSAGE_DISPLAY];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->post_chat_message_display(plugin, barejid, resource, message);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_chat_message_send(const char * const barejid, const char *message)
 {
+    GList *curr = subscribers[HOOK_PRE_CHAT_MESSAGE_SEND];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_message = plugin->pre_chat_message_send(plugin, barejid, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -430,35 +438,34 @@ plugins_pre_chat_message_send(const char * const barejid, const char *message)
 void
 plugins_post_chat_message_send(const char * const barejid, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_POST_CHAT_MESSAGE_SEND];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->post_chat_message_send(plugin, barejid, message);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_room_message_display(const char * const barejid, const char * const nick, const char *message)
 {
+    GList *curr = subscribers[HOOK_PRE_ROOM_MESSAGE_DISPLAY];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_message = plugin->pre_room_message_display(plugin, barejid, nick, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -466,35 +473,34 @@ plugins_pre_room_message_display(const char * const barejid, const char * const
 void
 plugins_post_room_message_display(const char * const barejid, const char * const nick, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_POST_ROOM_MESSAGE_DISPLAY];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->post_room_message_display(plugin, barejid, nick, message);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_room_message_send(const char * const barejid, const char *message)
 {
+    GList *curr = subscribers[HOOK_PRE_ROOM_MESSAGE_SEND];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_message = plugin->pre_room_message_send(plugin, barejid, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -502,59 +508,66 @@ plugins_pre_room_message_send(const char * const barejid, const char *message)
 void
 plugins_post_room_message_send(const char * const barejid, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_POST_ROOM_MESSAGE_SEND];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->post_room_message_send(plugin, barejid, message);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
-plugins_on_room_history_message(const char *const barejid, const char *const nick, const char *const message,
-    GDateTime *timestamp)
+plugins_on_room_history_messages(const char *const barejid, GList *history)
 {
-    char *timestamp_str = NULL;
-    GTimeVal timestamp_tv;
-    gboolean res = g_date_time_to_timeval(timestamp, &timestamp_tv);
-    if (res) {
-        timestamp_str = g_time_val_to_iso8601(&timestamp_tv);
+    GList *subscribed = subscribers[HOOK_ON_ROOM_HISTORY_MESSAGE];
+    if (subscribed == NULL) {
+        return;
     }
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        plugin->on_room_history_message(plugin, barejid, nick, message, timestamp_str);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    GList *curr_history = history;
+    while (curr_history) {
+        MucHistory *entry = curr_history->data;
 
-    free(timestamp_str);
+        char *timestamp_str = NULL;
+        GTimeVal timestamp_tv;
+        gboolean res = g_date_time_to_timeval(entry->timestamp, &timestamp_tv);
+        if (res) {
+            timestamp_str = g_time_val_to_iso8601(&timestamp_tv);
+        }
+
+        GList *curr = subscribed;
+        while (curr) {
+            ProfPlugin *plugin = curr->data;
+            plugin->on_room_history_message(plugin, barejid, entry->nick, entry->message, timestamp_str);
+            curr = g_list_next(curr);
+        }
+
+        free(timestamp_str);
+        curr_history = g_list_next(curr_history);
+    }
 }
 
 char*
 plugins_pre_priv_message_display(const char * const fulljid, const char *message)
 {
+    GList *curr = subscribers[HOOK_PRE_PRIV_MESSAGE_DISPLAY];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     Jid *jidp = jid_create(fulljid);
     char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_message = plugin->pre_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
     return curr_message;
@@ -563,16 +576,18 @@ plugins_pre_priv_message_display(const char * const fulljid, const char *message
 void
 plugins_post_priv_message_display(const char * const fulljid, const char *message)
 {
+    GList *curr = subscribers[HOOK_POST_PRIV_MESSAGE_DISPLAY];
+    if (curr == NULL) {
+        return;
+    }
+
     Jid *jidp = jid_create(fulljid);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->post_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, message);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
 }
@@ -580,23 +595,24 @@ plugins_post_priv_message_display(const char * const fulljid, const char *messag
 char*
 plugins_pre_priv_message_send(const char * const fulljid, const char * const message)
 {
+    GList *curr = subscribers[HOOK_PRE_PRIV_MESSAGE_SEND];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     Jid *jidp = jid_create(fulljid);
     char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_message = plugin->pre_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
     return curr_message;
@@ -605,16 +621,18 @@ plugins_pre_priv_message_send(const char * const fulljid, const char * const mes
 void
 plugins_post_priv_message_send(const char * const fulljid, const char * const message)
 {
+    GList *curr = subscribers[HOOK_POST_PRIV_MESSAGE_SEND];
+    if (curr == NULL) {
+        return;
+    }
+
     Jid *jidp = jid_create(fulljid);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->post_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, message);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
 }
@@ -622,22 +640,23 @@ plugins_post_priv_message_send(const char * const fulljid, const char * const me
 char*
 plugins_on_message_stanza_send(const char *const text)
 {
+    GList *curr = subscribers[HOOK_ON_MESSAGE_STANZA_SEND];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_stanza = NULL;
     char *curr_stanza = strdup(text);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_stanza = plugin->on_message_stanza_send(plugin, curr_stanza);
         if (new_stanza) {
             free(curr_stanza);
-            curr_stanza = strdup(new_stanza);
-            free(new_stanza);
+            curr_stanza = new_stanza;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_stanza;
 }
@@ -647,8 +666,7 @@ plugins_on_message_stanza_receive(const char *const text)
 {
     gboolean cont = TRUE;
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_MESSAGE_STANZA_RECEIVE];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         gboolean res = plugin->on_message_stanza_receive(plugin, text);
@@ -657,7 +675,6 @@ plugins_on_message_stanza_receive(const char *const text)
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return cont;
 }
@@ -665,22 +682,23 @@ plugins_on_message_stanza_receive(const char *const text)
 char*
 plugins_on_presence_stanza_send(const char *const text)
 {
+    GList *curr = subscribers[HOOK_ON_PRESENCE_STANZA_SEND];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_stanza = NULL;
     char *curr_stanza = strdup(text);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_stanza = plugin->on_presence_stanza_send(plugin, curr_stanza);
         if (new_stanza) {
             free(curr_stanza);
-            curr_stanza = strdup(new_stanza);
-            free(new_stanza);
+            curr_stanza = new_stanza;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_stanza;
 }
@@ -690,8 +708,7 @@ plugins_on_presence_stanza_receive(const char *const text)
 {
     gboolean cont = TRUE;
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_PRESENCE_STANZA_RECEIVE];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         gboolean res = plugin->on_presence_stanza_receive(plugin, text);
@@ -700,7 +717,6 @@ plugins_on_presence_stanza_receive(const char *const text)
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return cont;
 }
@@ -708,22 +724,23 @@ plugins_on_presence_stanza_receive(const char *const text)
 char*
 plugins_on_iq_stanza_send(const char *const text)
 {
+    GList *curr = subscribers[HOOK_ON_IQ_STANZA_SEND];
+    if (curr == NULL) {
+        return NULL;
+    }
+
     char *new_stanza = NULL;
     char *curr_stanza = strdup(text);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
     while (curr) {
         ProfPlugin *plugin = curr->data;
         new_stanza = plugin->on_iq_stanza_send(plugin, curr_stanza);
         if (new_stanza) {
             free(curr_stanza);
-            curr_stanza = strdup(new_stanza);
-            free(new_stanza);
+            curr_stanza = new_stanza;
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_stanza;
 }
@@ -733,8 +750,7 @@ plugins_on_iq_stanza_receive(const char *const text)
 {
     gboolean cont = TRUE;
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_IQ_STANZA_RECEIVE];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         gboolean res = plugin->on_iq_stanza_receive(plugin, text);
@@ -743,7 +759,6 @@ plugins_on_iq_stanza_receive(const char *const text)
         }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return cont;
 }
@@ -751,53 +766,45 @@ plugins_on_iq_stanza_receive(const char *const text)
 void
 plugins_on_contact_offline(const char *const barejid, const char *const resource, const char *const status)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_CONTACT_OFFLINE];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_contact_offline(plugin, barejid, resource, status);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_contact_presence(const char *const barejid, const char *const resource, const char *const presence, const char *const status, const int priority)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_CONTACT_PRESENCE];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_contact_presence(plugin, barejid, resource, presence, status, priority);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_chat_win_focus(const char *const barejid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_CHAT_WIN_FOCUS];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_chat_win_focus(plugin, barejid);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_room_win_focus(const char *const barejid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
+    GList *curr = subscribers[HOOK_ON_ROOM_WIN_FOCUS];
     while (curr) {
         ProfPlugin *plugin = curr->data;
         plugin->on_room_win_focus(plugin, barejid);
         curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 GList*
@@ -841,4 +848,97 @@ plugins_shutdown(void)
     disco_close();
     g_hash_table_destroy(plugins);
     plugins = NULL;
+    _plugins_update_subscribers();
+}
+
+static gboolean
+_plugin_has_hook(ProfPlugin *plugin, plugin_hook_t hook)
+{
+    switch (hook)
+    {
+        case HOOK_ON_START:
+            return plugin->on_start_func != NULL;
+        case HOOK_ON_SHUTDOWN:
+            return plugin->on_shutdown_func != NULL;
+        case HOOK_ON_CONNECT:
+            return plugin->on_connect_func != NULL;
+        case HOOK_ON_DISCONNECT:
+            return plugin->on_disconnect_func != NULL;
+        case HOOK_PRE_CHAT_MESSAGE_DISPLAY:
+            return plugin->pre_chat_message_display != NULL;
+        case HOOK_POST_CHAT_MESSAGE_DISPLAY:
+            return plugin->post_chat_message_display != NULL;
+        case HOOK_PRE_CHAT_MESSAGE_SEND:
+            return plugin->pre_chat_message_send != NULL;
+        case HOOK_POST_CHAT_MESSAGE_SEND:
+            return plugin->post_chat_message_send != NULL;
+        case HOOK_PRE_ROOM_MESSAGE_DISPLAY:
+            return plugin->pre_room_message_display != NULL;
+        case HOOK_POST_ROOM_MESSAGE_DISPLAY:
+            return plugin->post_room_message_display != NULL;
+        case HOOK_PRE_ROOM_MESSAGE_SEND:
+            return plugin->pre_room_message_send != NULL;
+        case HOOK_POST_ROOM_MESSAGE_SEND:
+            return plugin->post_room_message_send != NULL;
+        case HOOK_ON_ROOM_HISTORY_MESSAGE:
+            return plugin->on_room_history_message != NULL;
+        case HOOK_PRE_PRIV_MESSAGE_DISPLAY:
+            return plugin->pre_priv_message_display != NULL;
+        case HOOK_POST_PRIV_MESSAGE_DISPLAY:
+            return plugin->post_priv_message_display != NULL;
+        case HOOK_PRE_PRIV_MESSAGE_SEND:
+            return plugin->pre_priv_message_send != NULL;
+        case HOOK_POST_PRIV_MESSAGE_SEND:
+            return plugin->post_priv_message_send != NULL;
+        case HOOK_ON_MESSAGE_STANZA_SEND:
+            return plugin->on_message_stanza_send != NULL;
+        case HOOK_ON_MESSAGE_STANZA_RECEIVE:
+            return plugin->on_message_stanza_receive != NULL;
+        case HOOK_ON_PRESENCE_STANZA_SEND:
+            return plugin->on_presence_stanza_send != NULL;
+        case HOOK_ON_PRESENCE_STANZA_RECEIVE:
+            return plugin->on_presence_stanza_receive != NULL;
+        case HOOK_ON_IQ_STANZA_SEND:
+            return plugin->on_iq_stanza_send != NULL;
+        case HOOK_ON_IQ_STANZA_RECEIVE:
+            return plugin->on_iq_stanza_receive != NULL;
+        case HOOK_ON_CONTACT_OFFLINE:
+            return plugin->on_contact_offline != NULL;
+        case HOOK_ON_CONTACT_PRESENCE:
+            return plugin->on_contact_presence != NULL;
+        case HOOK_ON_CHAT_WIN_FOCUS:
+            return plugin->on_chat_win_focus != NULL;
+        case HOOK_ON_ROOM_WIN_FOCUS:
+            return plugin->on_room_win_focus != NULL;
+        default:
+            return FALSE;
+    }
+}
+
+// rebuild the list of plugins implementing each hook, called whenever a plugin is loaded or unloaded
+static void
+_plugins_update_subscribers(void)
+{
+    int i;
+    for (i = 0; i < HOOK_COUNT; i++) {
+        g_list_free(subscribers[i]);
+        subscribers[i] = NULL;
+    }
+
+    if (plugins == NULL) {
+        return;
+    }
+
+    GList *values = g_hash_table_get_values(plugins);
+    GList *curr = values;
+    while (curr) {
+        ProfPlugin *plugin = curr->data;
+        for (i = 0; i < HOOK_COUNT; i++) {
+            if (_plugin_has_hook(plugin, i)) {
+                subscribers[i] = g_list_append(subscribers[i], plugin);
+            }
+        }
+        curr = g_list_next(curr);
+    }
+    g_list_free(values);
 }
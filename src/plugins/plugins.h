@@ -42,6 +42,38 @@ typedef enum {
     LANG_C
 } lang_t;
 
+// hooks a plugin may implement, a plugin's function for a hook is NULL when not implemented
+typedef enum {
+    HOOK_ON_START,
+    HOOK_ON_SHUTDOWN,
+    HOOK_ON_CONNECT,
+    HOOK_ON_DISCONNECT,
+    HOOK_PRE_CHAT_MESSAGE_DISPLAY,
+    HOOK_POST_CHAT_MESSAGE_DISPLAY,
+    HOOK_PRE_CHAT_MESSAGE_SEND,
+    HOOK_POST_CHAT_MESSAGE_SEND,
+    HOOK_PRE_ROOM_MESSAGE_DISPLAY,
+    HOOK_POST_ROOM_MESSAGE_DISPLAY,
+    HOOK_PRE_ROOM_MESSAGE_SEND,
+    HOOK_POST_ROOM_MESSAGE_SEND,
+    HOOK_ON_ROOM_HISTORY_MESSAGE,
+    HOOK_PRE_PRIV_MESSAGE_DISPLAY,
+    HOOK_POST_PRIV_MESSAGE_DISPLAY,
+    HOOK_PRE_PRIV_MESSAGE_SEND,
+    HOOK_POST_PRIV_MESSAGE_SEND,
+    HOOK_ON_MESSAGE_STANZA_SEND,
+    HOOK_ON_MESSAGE_STANZA_RECEIVE,
+    HOOK_ON_PRESENCE_STANZA_SEND,
+    HOOK_ON_PRESENCE_STANZA_RECEIVE,
+    HOOK_ON_IQ_STANZA_SEND,
+    HOOK_ON_IQ_STANZA_RECEIVE,
+    HOOK_ON_CONTACT_OFFLINE,
+    HOOK_ON_CONTACT_PRESENCE,
+    HOOK_ON_CHAT_WIN_FOCUS,
+    HOOK_ON_ROOM_WIN_FOCUS,
+    HOOK_COUNT
+} plugin_hook_t;
+
 typedef struct prof_plugin_t {
     char *name;
     lang_t lang;
@@ -101,6 +133,7 @@ typedef struct prof_plugin_t {
 void plugins_init(void);
 GSList *plugins_unloaded_list(void);
 GList *plugins_loaded_list(void);
+gboolean plugins_has_hook(plugin_hook_t hook);
 char* plugins_autocomplete(const char *const input);
 void plugins_reset_autocomplete(void);
 void plugins_shutdown(void);
@@ -117,6 +150,7 @@ void plugins_on_shutdown(void);
 void plugins_on_connect(const char *const account_name, const char *const fulljid);
 void plugins_on_disconnect(const char *const account_name, const char *const fulljid);
 
+// pre hooks return the message as modified by plugins, or NULL when no loaded plugin implements the hook
 char* plugins_pre_chat_message_display(const char *const barejid, const char *const resource, const char *message);
 void plugins_post_chat_message_display(const char *const barejid, const char *const resource, const char *message);
 char* plugins_pre_chat_message_send(const char *const barejid, const char *message);
@@ -126,8 +160,7 @@ char* plugins_pre_room_message_display(const char *const barejid, const char *co
 void plugins_post_room_message_display(const char *const barejid, const char *const nick, const char *message);
 char* plugins_pre_room_message_send(const char *const barejid, const char *message);
 void plugins_post_room_message_send(const char *const barejid, const char *message);
-void plugins_on_room_history_message(const char *const barejid, const char *const nick, const char *const message,
-    GDateTime *timestamp);
+void plugins_on_room_history_messages(const char *const barejid, GList *history);
 
 char* plugins_pre_priv_message_display(const char *const fulljid, const char *message);
 void plugins_post_priv_message_display(const char *const fulljid, const char *message);
@@ -125,34 +125,34 @@ python_plugin_create(const char *const filename)
         plugin->lang = LANG_PYTHON;
         plugin->module = p_module;
         plugin->init_func = python_init_hook;
-        plugin->on_start_func = python_on_start_hook;
-        plugin->on_shutdown_func = python_on_shutdown_hook;
-        plugin->on_unload_func = python_on_unload_hook;
-        plugin->on_connect_func = python_on_connect_hook;
-        plugin->on_disconnect_func = python_on_disconnect_hook;
-        plugin->pre_chat_message_display = python_pre_chat_message_display_hook;
-        plugin->post_chat_message_display = python_post_chat_message_display_hook;
-        plugin->pre_chat_message_send = python_pre_chat_message_send_hook;
-        plugin->post_chat_message_send = python_post_chat_message_send_hook;
-        plugin->pre_room_message_display = python_pre_room_message_display_hook;
-        plugin->post_room_message_display = python_post_room_message_display_hook;
-        plugin->pre_room_message_send = python_pre_room_message_send_hook;
-        plugin->post_room_message_send = python_post_room_message_send_hook;
-        plugin->on_room_history_message = python_on_room_history_message_hook;
-        plugin->pre_priv_message_display = python_pre_priv_message_display_hook;
-        plugin->post_priv_message_display = python_post_priv_message_display_hook;
-        plugin->pre_priv_message_send = python_pre_priv_message_send_hook;
-        plugin->post_priv_message_send = python_post_priv_message_send_hook;
-        plugin->on_message_stanza_send = python_on_message_stanza_send_hook;
-        plugin->on_message_stanza_receive = python_on_message_stanza_receive_hook;
-        plugin->on_presence_stanza_send = python_on_presence_stanza_send_hook;
-        plugin->on_presence_stanza_receive = python_on_presence_stanza_receive_hook;
-        plugin->on_iq_stanza_send = python_on_iq_stanza_send_hook;
-        plugin->on_iq_stanza_receive = python_on_iq_stanza_receive_hook;
-        plugin->on_contact_offline = python_on_contact_offline_hook;
-        plugin->on_contact_presence = python_on_contact_presence_hook;
-        plugin->on_chat_win_focus = python_on_chat_win_focus_hook;
-        plugin->on_room_win_focus = python_on_room_win_focus_hook;
+        plugin->on_start_func = PyObject_HasAttrString(p_module, "prof_on_start") ? python_on_start_hook : NULL;
+        plugin->on_shutdown_func = PyObject_HasAttrString(p_module, "prof_on_shutdown") ? python_on_shutdown_hook : NULL;
+        plugin->on_unload_func = PyObject_HasAttrString(p_module, "prof_on_unload") ? python_on_unload_hook : NULL;
+        plugin->on_connect_func = PyObject_HasAttrString(p_module, "prof_on_connect") ? python_on_connect_hook : NULL;
+        plugin->on_disconnect_func = PyObject_HasAttrString(p_module, "prof_on_disconnect") ? python_on_disconnect_hook : NULL;
+        plugin->pre_chat_message_display = PyObject_HasAttrString(p_module, "prof_pre_chat_message_display") ? python_pre_chat_message_display_hook : NULL;
+        plugin->post_chat_message_display = PyObject_HasAttrString(p_module, "prof_post_chat_message_display") ? python_post_chat_message_display_hook : NULL;
+        plugin->pre_chat_message_send = PyObject_HasAttrString(p_module, "prof_pre_chat_message_send") ? python_pre_chat_message_send_hook : NULL;
+        plugin->post_chat_message_send = PyObject_HasAttrString(p_module, "prof_post_chat_message_send") ? python_post_chat_message_send_hook : NULL;
+        plugin->pre_room_message_display = PyObject_HasAttrString(p_module, "prof_pre_room_message_display") ? python_pre_room_message_display_hook : NULL;
+        plugin->post_room_message_display = PyObject_HasAttrString(p_module, "prof_post_room_message_display") ? python_post_room_message_display_hook : NULL;
+        plugin->pre_room_message_send = PyObject_HasAttrString(p_module, "prof_pre_room_message_send") ? python_pre_room_message_send_hook : NULL;
+        plugin->post_room_message_send = PyObject_HasAttrString(p_module, "prof_post_room_message_send") ? python_post_room_message_send_hook : NULL;
+        plugin->on_room_history_message = PyObject_HasAttrString(p_module, "prof_on_room_history_message") ? python_on_room_history_message_hook : NULL;
+        plugin->pre_priv_message_display = PyObject_HasAttrString(p_module, "prof_pre_priv_message_display") ? python_pre_priv_message_display_hook : NULL;
+        plugin->post_priv_message_display = PyObject_HasAttrString(p_module, "prof_post_priv_message_display") ? python_post_priv_message_display_hook : NULL;
+        plugin->pre_priv_message_send = PyObject_HasAttrString(p_module, "prof_pre_priv_message_send") ? python_pre_priv_message_send_hook : NULL;
+        plugin->post_priv_message_send = PyObject_HasAttrString(p_module, "prof_post_priv_message_send") ? python_post_priv_message_send_hook : NULL;
+        plugin->on_message_stanza_send = PyObject_HasAttrString(p_module, "prof_on_message_stanza_send") ? python_on_message_stanza_send_hook : NULL;
+        plugin->on_message_stanza_receive = PyObject_HasAttrString(p_module, "prof_on_message_stanza_receive") ? python_on_message_stanza_receive_hook : NULL;
+        plugin->on_presence_stanza_send = PyObject_HasAttrString(p_module, "prof_on_presence_stanza_send") ? python_on_presence_stanza_send_hook : NULL;
+        plugin->on_presence_stanza_receive = PyObject_HasAttrString(p_module, "prof_on_presence_stanza_receive") ? python_on_presence_stanza_receive_hook : NULL;
+        plugin->on_iq_stanza_send = PyObject_HasAttrString(p_module, "prof_on_iq_stanza_send") ? python_on_iq_stanza_send_hook : NULL;
+        plugin->on_iq_stanza_receive = PyObject_HasAttrString(p_module, "prof_on_iq_stanza_receive") ? python_on_iq_stanza_receive_hook : NULL;
+        plugin->on_contact_offline = PyObject_HasAttrString(p_module, "prof_on_contact_offline") ? python_on_contact_offline_hook : NULL;
+        plugin->on_contact_presence = PyObject_HasAttrString(p_module, "prof_on_contact_presence") ? python_on_contact_presence_hook : NULL;
+        plugin->on_chat_win_focus = PyObject_HasAttrString(p_module, "prof_on_chat_win_focus") ? python_on_chat_win_focus_hook : NULL;
+        plugin->on_room_win_focus = PyObject_HasAttrString(p_module, "prof_on_room_win_focus") ? python_on_room_win_focus_hook : NULL;
 
         allow_python_threads();
         return plugin;
@@ -42,8 +42,10 @@
 #include "config/theme.h"
 #include "config/files.h"
 #include "config/conflists.h"
+#include "config/persist.h"
 
 static GKeyFile *settings;
+static PersistStore *settings_store;
 
 static void _save_settings(void);
 
@@ -58,18 +60,17 @@ plugin_settings_init(void)
 
     settings = g_key_file_new();
     g_key_file_load_from_file(settings, settings_file, G_KEY_FILE_KEEP_COMMENTS, NULL);
-
-    gsize g_data_size;
-    gchar *g_data = g_key_file_to_data(settings, &g_data_size, NULL);
-    g_file_set_contents(settings_file, g_data, g_data_size, NULL);
-    g_chmod(settings_file, S_IRUSR | S_IWUSR);
-    g_free(g_data);
+    settings_store = persist_store_new(settings, settings_file, PERSIST_DEFAULT_DELAY);
     free(settings_file);
+
+    _save_settings();
 }
 
 void
 plugin_settings_close(void)
 {
+    persist_store_free(settings_store);
+    settings_store = NULL;
     g_key_file_free(settings);
     settings = NULL;
 }
@@ -171,16 +172,5 @@ plugin_settings_string_list_clear(const char *const group, const char *const key
 static void
 _save_settings(void)
 {
-    gsize g_data_size;
-    gchar *g_data = g_key_file_to_data(settings, &g_data_size, NULL);
-
-    char *fileloc = files_get_data_path(FILE_PLUGIN_SETTINGS);
-    gchar *base = g_path_get_basename(fileloc);
-    gchar *true_loc = get_file_or_linked(fileloc, base);
-    g_free(base);
-    g_file_set_contents(true_loc, g_data, g_data_size, NULL);
-    free(true_loc);
-    g_free(g_data);
-    g_chmod(fileloc, S_IRUSR | S_IWUSR);
-    free(fileloc);
+    persist_store_mark_dirty(settings_store);
 }
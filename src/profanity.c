@@ -58,15 +58,19 @@
 #include "config/theme.h"
 #include "config/tlscerts.h"
 #include "config/scripts.h"
+#include "config/persist.h"
 #include "command/cmd_defs.h"
 #include "plugins/plugins.h"
 #include "event/client_events.h"
+#include "event/server_events.h"
+#include "tools/http_upload.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/resource.h"
 #include "xmpp/session.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/muc.h"
+#include "xmpp/jid.h"
 #include "xmpp/chat_session.h"
 #include "xmpp/chat_state.h"
 #include "xmpp/contact.h"
@@ -117,11 +121,17 @@ prof_run(char *log_level, char *account_name)
 
 #ifdef HAVE_LIBOTR
         otr_poll();
+#endif
+#ifdef HAVE_LIBGPGME
+        p_gpg_poll();
 #endif
         plugins_run_timed();
         notify_remind();
         session_process_events();
         iq_autoping_check();
+        sv_ev_room_history_check();
+        http_upload_check();
+        persist_check();
         ui_update();
 #ifdef HAVE_GTK
         tray_update();
@@ -227,7 +237,9 @@ _shutdown(void)
     session_shutdown();
     plugins_on_shutdown();
     muc_close();
+    sv_ev_close();
     caps_close();
+    jid_cache_clear();
 #ifdef HAVE_LIBOTR
     otr_shutdown();
 #endif
@@ -238,6 +250,9 @@ _shutdown(void)
     theme_close();
     accounts_close();
     tlscerts_close();
+    persist_flush_all();
+    log_debug("Config writes: %lu, avoided: %lu (%lu bytes)", persist_get_writes(), persist_get_writes_avoided(),
+        persist_get_bytes_avoided());
     log_stderr_close();
     log_close();
     plugins_shutdown();
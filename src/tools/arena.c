@@ -0,0 +1,233 @@
+/*
+ * arena.c
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "tools/arena.h"
+
+#define ARENA_ALIGN 8
+#define ALIGN_UP(n) (((n) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+typedef struct arena_block_t {
+    struct arena_block_t *next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+typedef struct arena_owned_t {
+    void *data;
+    GDestroyNotify destroy;
+    struct arena_owned_t *next;
+} ArenaOwned;
+
+struct arena_t {
+    size_t block_size;
+    ArenaBlock *blocks;
+    ArenaOwned *owned;
+    gulong allocs;
+    gulong block_allocs;
+    gulong resets;
+};
+
+static ArenaBlock* _arena_block_new(Arena arena, size_t size);
+
+Arena
+arena_new(size_t block_size)
+{
+    Arena arena = malloc(sizeof(struct arena_t));
+    arena->block_size = block_size;
+    arena->blocks = NULL;
+    arena->owned = NULL;
+    arena->allocs = 0;
+    arena->block_allocs = 0;
+    arena->resets = 0;
+
+    return arena;
+}
+
+void
+arena_free(Arena arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+
+    arena_reset(arena);
+    free(arena->blocks);
+    free(arena);
+}
+
+void*
+arena_alloc(Arena arena, size_t size)
+{
+    size = ALIGN_UP(size ? size : 1);
+    arena->allocs++;
+
+    ArenaBlock *block = arena->blocks;
+    if (block && block->size - block->used >= size) {
+        void *result = block->data + block->used;
+        block->used += size;
+        return result;
+    }
+
+    // large requests get a block of their own behind the current one
+    if (block && size > arena->block_size / 4) {
+        ArenaBlock *large = _arena_block_new(arena, size);
+        large->used = size;
+        large->next = block->next;
+        block->next = large;
+        return large->data;
+    }
+
+    block = _arena_block_new(arena, MAX(size, arena->block_size));
+    block->next = arena->blocks;
+    arena->blocks = block;
+    block->used = size;
+
+    return block->data;
+}
+
+char*
+arena_strdup(Arena arena, const char *const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    size_t len = strlen(str) + 1;
+    char *result = arena_alloc(arena, len);
+    memcpy(result, str, len);
+
+    return result;
+}
+
+char*
+arena_utf8_strdown(Arena arena, const char *const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    size_t len = strlen(str);
+    if (utf8_ascii_prefix_len(str, len) == len) {
+        char *result = arena_alloc(arena, len + 1);
+        size_t i;
+        for (i = 0; i < len; i++) {
+            result[i] = g_ascii_tolower(str[i]);
+        }
+        result[len] = '\0';
+        return result;
+    }
+
+    char *result = g_utf8_strdown(str, len);
+    arena_own(arena, result, g_free);
+
+    return result;
+}
+
+void
+arena_own(Arena arena, void *data, GDestroyNotify destroy)
+{
+    if (data == NULL) {
+        return;
+    }
+
+    ArenaOwned *owned = arena_alloc(arena, sizeof(ArenaOwned));
+    owned->data = data;
+    owned->destroy = destroy;
+    owned->next = arena->owned;
+    arena->owned = owned;
+}
+
+void
+arena_reset(Arena arena)
+{
+    ArenaOwned *owned = arena->owned;
+    while (owned) {
+        owned->destroy(owned->data);
+        owned = owned->next;
+    }
+    arena->owned = NULL;
+    arena->resets++;
+
+    ArenaBlock *block = arena->blocks;
+    if (block == NULL) {
+        return;
+    }
+
+    // keep the newest block, it is at least block_size
+    ArenaBlock *curr = block->next;
+    while (curr) {
+        ArenaBlock *next = curr->next;
+        free(curr);
+        curr = next;
+    }
+    block->next = NULL;
+    block->used = 0;
+}
+
+gulong
+arena_get_allocs(Arena arena)
+{
+    return arena->allocs;
+}
+
+gulong
+arena_get_blocks(Arena arena)
+{
+    return arena->block_allocs;
+}
+
+gulong
+arena_get_resets(Arena arena)
+{
+    return arena->resets;
+}
+
+static ArenaBlock*
+_arena_block_new(Arena arena, size_t size)
+{
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    arena->block_allocs++;
+
+    return block;
+}
@@ -0,0 +1,61 @@
+/*
+ * arena.h
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_ARENA_H
+#define TOOLS_ARENA_H
+
+#include <glib.h>
+
+typedef struct arena_t *Arena;
+
+// allocate an arena that hands out memory from blocks of block_size bytes
+Arena arena_new(size_t block_size);
+void arena_free(Arena arena);
+
+// memory from the arena is valid until the next arena_reset
+void* arena_alloc(Arena arena, size_t size);
+char* arena_strdup(Arena arena, const char *const str);
+char* arena_utf8_strdown(Arena arena, const char *const str);
+
+// call destroy on data when the arena is next reset, latest registered first
+void arena_own(Arena arena, void *data, GDestroyNotify destroy);
+
+// release everything allocated or owned since the last reset, keeping the first block
+void arena_reset(Arena arena);
+
+gulong arena_get_allocs(Arena arena);
+gulong arena_get_blocks(Arena arena);
+gulong arena_get_resets(Arena arena);
+
+#endif
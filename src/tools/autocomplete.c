@@ -38,14 +38,23 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
 #include "tools/parser.h"
 
 struct autocomplete_t {
     GSList *items;
     GSList *last_found;
     gchar *search_str;
+    char* (*copy_item)(const char *const);
+    GDestroyNotify free_item;
 };
 
+static char*
+_copy_item(const char *const item)
+{
+    return strdup(item);
+}
+
 static gchar* _search_from(Autocomplete ac, GSList *curr, gboolean quote);
 
 Autocomplete
@@ -55,6 +64,18 @@ autocomplete_new(void)
     new->items = NULL;
     new->last_found = NULL;
     new->search_str = NULL;
+    new->copy_item = _copy_item;
+    new->free_item = free;
+
+    return new;
+}
+
+Autocomplete
+autocomplete_new_interned(void)
+{
+    Autocomplete new = autocomplete_new();
+    new->copy_item = intern_ref;
+    new->free_item = (GDestroyNotify)intern_unref;
 
     return new;
 }
@@ -63,7 +84,7 @@ void
 autocomplete_clear(Autocomplete ac)
 {
     if (ac) {
-        g_slist_free_full(ac->items, free);
+        g_slist_free_full(ac->items, ac->free_item);
         ac->items = NULL;
 
         autocomplete_reset(ac);
@@ -110,7 +131,7 @@ autocomplete_add(Autocomplete ac, const char *item)
             return;
         }
 
-        item_cpy = strdup(item);
+        item_cpy = ac->copy_item(item);
         ac->items = g_slist_insert_sorted(ac->items, item_cpy, (GCompareFunc)strcmp);
     }
 
@@ -141,7 +162,7 @@ autocomplete_remove(Autocomplete ac, const char *const item)
             ac->last_found = NULL;
         }
 
-        free(curr->data);
+        ac->free_item(curr->data);
         ac->items = g_slist_delete_link(ac->items, curr);
     }
 
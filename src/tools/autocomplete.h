@@ -43,6 +43,9 @@ typedef struct autocomplete_t *Autocomplete;
 // allocate new autocompleter with no items
 Autocomplete autocomplete_new(void);
 
+// allocate new autocompleter whose items are shared with tools/intern
+Autocomplete autocomplete_new_interned(void);
+
 // Remove all items from the autocompleter
 void autocomplete_clear(Autocomplete ac);
 
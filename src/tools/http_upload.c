@@ -39,12 +39,16 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
 #include <pthread.h>
 #include <assert.h>
 
 #include "profanity.h"
+#include "log.h"
 #include "event/client_events.h"
 #include "tools/http_upload.h"
 #include "config/preferences.h"
@@ -56,48 +60,114 @@
 #define FALLBACK_MSG ""
 #define FILE_HEADER_BYTES 512
 
+// shortest time between progress updates shown for an upload
+#define PROGRESS_INTERVAL (250 * G_TIME_SPAN_MILLISECOND)
+
+// how long the upload thread waits for socket activity before checking its queue
+#define WORKER_WAIT_MS 100
+
+// size of the chunks curl asks for when sending the file
+#define UPLOAD_BUFFER_SIZE (256 * 1024)
+
+// attempts made after an upload is interrupted, and the longest wait between them in seconds
+#define UPLOAD_MAX_RETRIES 5
+#define UPLOAD_RETRY_MAX_DELAY 30
+
+// seconds without any data moving before a transfer is treated as dropped
+#define UPLOAD_STALL_TIMEOUT 60
+
 struct curl_data_t {
     char *buffer;
     size_t size;
 };
 
+struct upload_job_t {
+    HTTPUpload *upload;
+    CURL *curl;
+    const char *map;            // the file mapped read only, NULL when empty
+    int map_fd;                 // kept open while mapped to notice the file shrinking
+    gboolean truncated;
+    size_t map_size;
+    size_t map_offset;
+    size_t resume_from;         // bytes the server holds from an earlier attempt
+    int attempts;
+    gint64 retry_at;
+    gboolean probing;
+    gboolean accept_ranges;
+    struct curl_slist *headers;
+    char *content_type_header;
+    char *cert_path;
+    struct curl_data_t output;
+};
+
+// all transfers run on one thread sharing a multi handle, so connections to the upload host are reused
+static pthread_t worker;
+static gboolean worker_started = FALSE;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static GQueue *queue = NULL;
+static int max_active = 1;
+static CURLM *multi = NULL;
+
 
 static int
 _xferinfo(void *userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
 {
-    HTTPUpload *upload = (HTTPUpload *)userdata;
+    struct upload_job_t *job = (struct upload_job_t *)userdata;
+    HTTPUpload *upload = job->upload;
 
-    pthread_mutex_lock(&lock);
-
-    if (upload->cancel) {
-        pthread_mutex_unlock(&lock);
+    if (g_atomic_int_get(&upload->cancel)) {
         return 1;
     }
 
-    if (upload->bytes_sent == ulnow) {
-        pthread_mutex_unlock(&lock);
+    if (job->probing || ultotal == 0) {
         return 0;
-    } else {
-        upload->bytes_sent = ulnow;
-    }
-
-    unsigned int ulperc = 0;
-    if (ultotal != 0) {
-        ulperc = (100 * ulnow) / ultotal;
     }
 
-    char *msg;
-    if (asprintf(&msg, "Uploading '%s': %d%%", upload->filename, ulperc) == -1) {
-        msg = strdup(FALLBACK_MSG);
+    curl_off_t sent = job->resume_from + ulnow;
+    if (upload->bytes_sent == sent) {
+        return 0;
     }
-    win_update_entry_message(upload->window, upload->put_url, msg);
-    free(msg);
+    upload->bytes_sent = sent;
 
-    pthread_mutex_unlock(&lock);
+    // shown by http_upload_check on the main thread, without taking the UI lock here
+    g_atomic_int_set(&upload->progress, (int)((100 * sent) / job->map_size));
 
     return 0;
 }
 
+void
+http_upload_check(void)
+{
+    static gint64 last_check = 0;
+
+    if (upload_processes == NULL) {
+        return;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (now - last_check < PROGRESS_INTERVAL) {
+        return;
+    }
+    last_check = now;
+
+    GSList *curr = upload_processes;
+    while (curr) {
+        HTTPUpload *upload = curr->data;
+        int progress = g_atomic_int_get(&upload->progress);
+        if (!g_atomic_int_get(&upload->cancel) && progress != upload->progress_shown && upload->put_url) {
+            upload->progress_shown = progress;
+            char *msg;
+            if (asprintf(&msg, "Uploading '%s': %d%%", upload->filename, progress) == -1) {
+                msg = strdup(FALLBACK_MSG);
+            }
+            win_update_entry_message(upload->window, upload->put_url, msg);
+            free(msg);
+        }
+        curr = g_slist_next(curr);
+    }
+}
+
 #if LIBCURL_VERSION_NUM < 0x072000
 static int
 _older_progress(void *p, double dltotal, double dlnow, double ultotal, double ulnow)
@@ -123,119 +193,108 @@ _data_callback(void *ptr, size_t size, size_t nmemb, void *data)
     return realsize;
 }
 
-void *
-http_file_put(void *userdata)
+static size_t
+_header_callback(char *buffer, size_t size, size_t nitems, void *userdata)
 {
-    HTTPUpload *upload = (HTTPUpload *)userdata;
-
-    FILE *fd = NULL;
-
-    char *err = NULL;
-    char *content_type_header;
+    struct upload_job_t *job = (struct upload_job_t *)userdata;
+    size_t len = size * nitems;
 
-    CURL *curl;
-    CURLcode res;
-
-    upload->cancel = 0;
-    upload->bytes_sent = 0;
-
-    pthread_mutex_lock(&lock);
-    char* msg;
-    if (asprintf(&msg, "Uploading '%s': 0%%", upload->filename) == -1) {
-        msg = strdup(FALLBACK_MSG);
+    static const char accept_ranges[] = "Accept-Ranges: bytes";
+    size_t match = strlen(accept_ranges);
+    if (len >= match && g_ascii_strncasecmp(buffer, accept_ranges, match) == 0) {
+        job->accept_ranges = TRUE;
     }
-    win_print_with_receipt(upload->window, '!', 0, NULL, 0, THEME_TEXT_ME, NULL, msg, upload->put_url);
-    free(msg);
-
-    char *cert_path = prefs_get_string(PREF_TLS_CERTPATH);
-    pthread_mutex_unlock(&lock);
 
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-
-    curl_easy_setopt(curl, CURLOPT_URL, upload->put_url);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    return len;
+}
 
-    struct curl_slist *headers = NULL;
-    if (asprintf(&content_type_header, "Content-Type: %s", upload->mime_type) == -1) {
-        content_type_header = strdup(FALLBACK_CONTENTTYPE_HEADER);
+// map the file so curl is fed straight from the page cache rather than through stdio
+static gboolean
+_upload_map(struct upload_job_t *job)
+{
+    int fd = open(job->upload->filename, O_RDONLY);
+    if (fd == -1) {
+        return FALSE;
     }
-    headers = curl_slist_append(headers, content_type_header);
-    headers = curl_slist_append(headers, "Expect:");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
-    #if LIBCURL_VERSION_NUM >= 0x072000
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, upload);
-    #else
-    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
-    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, upload);
-    #endif
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-
-    struct curl_data_t output;
-    output.buffer = NULL;
-    output.size = 0;
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _data_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&output);
-
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return FALSE;
+    }
 
-    if (!(fd = fopen(upload->filename, "rb"))) {
-        if (asprintf(&err, "failed to open '%s'", upload->filename) == -1) {
-            err = NULL;
+    job->map_size = st.st_size;
+    job->map_offset = 0;
+    if (job->map_size > 0) {
+        void *map = mmap(NULL, job->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return FALSE;
         }
-        goto end;
+        madvise(map, job->map_size, MADV_SEQUENTIAL);
+        job->map = map;
+        job->map_fd = fd;
+    } else {
+        close(fd);
     }
 
-    if (cert_path) {
-        curl_easy_setopt(curl, CURLOPT_CAPATH, cert_path);
+    return TRUE;
+}
+
+static size_t
+_read_callback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    struct upload_job_t *job = (struct upload_job_t *)userdata;
+
+    size_t len = MIN(size * nitems, job->map_size - job->map_offset);
+    if (len > 0) {
+        // touching mapped pages past the end of a truncated file raises SIGBUS
+        struct stat st;
+        if (fstat(job->map_fd, &st) != 0 || (size_t)st.st_size < job->map_offset + len) {
+            job->truncated = TRUE;
+            return CURL_READFUNC_ABORT;
+        }
+        memcpy(buffer, job->map + job->map_offset, len);
+        job->map_offset += len;
     }
 
-    curl_easy_setopt(curl, CURLOPT_READDATA, fd);
-    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)(upload->filesize));
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    return len;
+}
 
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
-        err = strdup(curl_easy_strerror(res));
-    } else {
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+static int
+_seek_callback(void *userdata, curl_off_t offset, int origin)
+{
+    struct upload_job_t *job = (struct upload_job_t *)userdata;
 
-        if (output.buffer) {
-            output.buffer[output.size++] = '\0';
-        }
+    // offsets are into the body, which starts where the server's copy ends
+    if (origin != SEEK_SET || offset < 0 || (size_t)offset > job->map_size - job->resume_from) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    job->map_offset = job->resume_from + offset;
 
-        // XEP-0363 specifies 201 but prosody returns 200
-        if (http_code != 200 && http_code != 201) {
-            if (asprintf(&err, "Server returned %lu", http_code) == -1) {
-                err = NULL;
-            }
-        }
+    return CURL_SEEKFUNC_OK;
+}
 
-        #if 0
-        printf("HTTP Status: %lu\n", http_code);
-        printf("%s\n", output.buffer);
-        printf("%lu bytes retrieved\n", (long)output.size);
-        #endif
-    }
+static void
+_upload_finish(struct upload_job_t *job, char *err)
+{
+    HTTPUpload *upload = job->upload;
 
-end:
-    curl_easy_cleanup(curl);
-    curl_global_cleanup();
-    curl_slist_free_all(headers);
-    if (fd) {
-        fclose(fd);
+    curl_easy_cleanup(job->curl);
+    curl_slist_free_all(job->headers);
+    if (job->map) {
+        munmap((void *)job->map, job->map_size);
+        close(job->map_fd);
     }
-    free(content_type_header);
-    free(output.buffer);
+    free(job->content_type_header);
+    free(job->output.buffer);
 
     pthread_mutex_lock(&lock);
-    prefs_free_string(cert_path);
+    prefs_free_string(job->cert_path);
 
+    char *msg;
     if (err) {
-        char *msg;
-        if (upload->cancel) {
+        if (g_atomic_int_get(&upload->cancel)) {
             if (asprintf(&msg, "Uploading '%s' failed: Upload was canceled", upload->filename) == -1) {
                 msg = strdup(FALLBACK_MSG);
             }
@@ -249,7 +308,7 @@ end:
         free(msg);
         free(err);
     } else {
-        if (!upload->cancel) {
+        if (!g_atomic_int_get(&upload->cancel)) {
             if (asprintf(&msg, "Uploading '%s': 100%%", upload->filename) == -1) {
                 msg = strdup(FALLBACK_MSG);
             }
@@ -294,40 +353,444 @@ end:
     free(upload->get_url);
     free(upload->put_url);
     free(upload);
+    free(job);
+}
 
-    return NULL;
+// send the file from job->resume_from onwards
+static void
+_upload_send(struct upload_job_t *job)
+{
+    curl_easy_setopt(job->curl, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(job->curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    curl_easy_setopt(job->curl, CURLOPT_UPLOAD, 1L);
+
+    curl_slist_free_all(job->headers);
+    job->headers = NULL;
+    job->headers = curl_slist_append(job->headers, job->content_type_header);
+    job->headers = curl_slist_append(job->headers, "Expect:");
+    if (job->resume_from > 0) {
+        char *range;
+        if (asprintf(&range, "Content-Range: bytes %lu-%lu/%lu", (unsigned long)job->resume_from,
+                (unsigned long)job->map_size - 1, (unsigned long)job->map_size) != -1) {
+            job->headers = curl_slist_append(job->headers, range);
+            free(range);
+        }
+    }
+    curl_easy_setopt(job->curl, CURLOPT_HTTPHEADER, job->headers);
+
+    job->map_offset = job->resume_from;
+    curl_easy_setopt(job->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)(job->map_size - job->resume_from));
+
+    free(job->output.buffer);
+    job->output.buffer = NULL;
+    job->output.size = 0;
+
+    job->probing = FALSE;
+    curl_multi_add_handle(multi, job->curl);
 }
 
-char*
-file_mime_type(const char* const file_name)
+// ask the server how much of an interrupted upload it kept
+static void
+_upload_probe(struct upload_job_t *job)
 {
-    char *out_mime_type;
-    char file_header[FILE_HEADER_BYTES];
-    FILE *fd;
-    if (!(fd = fopen(file_name, "rb"))) {
-        return strdup(FALLBACK_MIMETYPE);
+    curl_easy_setopt(job->curl, CURLOPT_UPLOAD, 0L);
+    curl_easy_setopt(job->curl, CURLOPT_CUSTOMREQUEST, NULL);
+    curl_easy_setopt(job->curl, CURLOPT_HTTPHEADER, NULL);
+    curl_easy_setopt(job->curl, CURLOPT_NOBODY, 1L);
+
+    job->accept_ranges = FALSE;
+    job->probing = TRUE;
+    curl_multi_add_handle(multi, job->curl);
+}
+
+// the offset to resume from, only when the server reported a partial file and byte ranges
+static size_t
+_upload_resume_offset(struct upload_job_t *job, CURLcode res)
+{
+    if (res != CURLE_OK || !job->accept_ranges) {
+        return 0;
     }
-    size_t file_header_size = fread(file_header, 1, FILE_HEADER_BYTES, fd);
-    fclose(fd);
 
-    char *content_type = g_content_type_guess(file_name, (unsigned char*)file_header, file_header_size, NULL);
-    if (content_type != NULL) {
-        char *mime_type = g_content_type_get_mime_type(content_type);
-        out_mime_type = strdup(mime_type);
-        g_free(mime_type);
+    long http_code = 0;
+    curl_easy_getinfo(job->curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code != 200) {
+        return 0;
     }
-    else {
-        return strdup(FALLBACK_MIMETYPE);
+
+    #if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t length = -1;
+    curl_easy_getinfo(job->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+    #else
+    double length = -1;
+    curl_easy_getinfo(job->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &length);
+    #endif
+    if (length <= 0 || (size_t)length >= job->map_size) {
+        return 0;
     }
-    g_free(content_type);
-    return out_mime_type;
+
+    return (size_t)length;
 }
 
-off_t file_size(const char* const filename)
+// set up the transfer and hand it to the multi handle, returns FALSE if it already finished
+static gboolean
+_upload_begin(struct upload_job_t *job)
 {
+    HTTPUpload *upload = job->upload;
+    char *err = NULL;
+
+    if (g_atomic_int_get(&upload->cancel)) {
+        _upload_finish(job, strdup("canceled"));
+        return FALSE;
+    }
+
+    if (!_upload_map(job)) {
+        if (asprintf(&err, "failed to open '%s'", upload->filename) == -1) {
+            err = strdup("failed to open file");
+        }
+        _upload_finish(job, err);
+        return FALSE;
+    }
+
+    if (asprintf(&job->content_type_header, "Content-Type: %s", upload->mime_type) == -1) {
+        job->content_type_header = strdup(FALLBACK_CONTENTTYPE_HEADER);
+    }
+
+    job->curl = curl_easy_init();
+    curl_easy_setopt(job->curl, CURLOPT_URL, upload->put_url);
+
+    #if LIBCURL_VERSION_NUM >= 0x072000
+    curl_easy_setopt(job->curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
+    curl_easy_setopt(job->curl, CURLOPT_XFERINFODATA, job);
+    #else
+    curl_easy_setopt(job->curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
+    curl_easy_setopt(job->curl, CURLOPT_PROGRESSDATA, job);
+    #endif
+    curl_easy_setopt(job->curl, CURLOPT_NOPROGRESS, 0L);
+
+    curl_easy_setopt(job->curl, CURLOPT_WRITEFUNCTION, _data_callback);
+    curl_easy_setopt(job->curl, CURLOPT_WRITEDATA, (void *)&job->output);
+    curl_easy_setopt(job->curl, CURLOPT_HEADERFUNCTION, _header_callback);
+    curl_easy_setopt(job->curl, CURLOPT_HEADERDATA, job);
+
+    curl_easy_setopt(job->curl, CURLOPT_USERAGENT, "profanity");
+    curl_easy_setopt(job->curl, CURLOPT_PRIVATE, job);
+    #if LIBCURL_VERSION_NUM >= 0x071900
+    curl_easy_setopt(job->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    #endif
+
+    // a connection that silently stops moving data counts as dropped, so it gets retried
+    curl_easy_setopt(job->curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(job->curl, CURLOPT_LOW_SPEED_TIME, (long)UPLOAD_STALL_TIMEOUT);
+
+    if (job->cert_path) {
+        curl_easy_setopt(job->curl, CURLOPT_CAPATH, job->cert_path);
+    }
+
+    curl_easy_setopt(job->curl, CURLOPT_READFUNCTION, _read_callback);
+    curl_easy_setopt(job->curl, CURLOPT_READDATA, job);
+    curl_easy_setopt(job->curl, CURLOPT_SEEKFUNCTION, _seek_callback);
+    curl_easy_setopt(job->curl, CURLOPT_SEEKDATA, job);
+    #if LIBCURL_VERSION_NUM >= 0x073e00
+    curl_easy_setopt(job->curl, CURLOPT_UPLOAD_BUFFERSIZE, (long)UPLOAD_BUFFER_SIZE);
+    #endif
+
+    _upload_send(job);
+
+    return TRUE;
+}
+
+static char*
+_upload_result(struct upload_job_t *job, CURLcode res, gboolean *retry)
+{
+    char *err = NULL;
+
+    if (job->truncated) {
+        *retry = FALSE;
+        return strdup("file was truncated during upload");
+    }
+
+    if (res != CURLE_OK) {
+        switch (res) {
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+            *retry = TRUE;
+            break;
+        default:
+            *retry = FALSE;
+            break;
+        }
+        return strdup(curl_easy_strerror(res));
+    }
+
+    long http_code = 0;
+    curl_easy_getinfo(job->curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+    // XEP-0363 specifies 201 but prosody returns 200
+    if (http_code != 200 && http_code != 201) {
+        if (asprintf(&err, "Server returned %lu", http_code) == -1) {
+            err = strdup("unexpected server response");
+        }
+        *retry = http_code == 408 || http_code >= 500;
+    }
+
+    return err;
+}
+
+// wait before the next attempt, doubling from one second up to a limit
+static gint64
+_upload_retry_delay(int attempt)
+{
+    gint64 delay = G_TIME_SPAN_SECOND << MIN(attempt, 16);
+    return MIN(delay, UPLOAD_RETRY_MAX_DELAY * G_TIME_SPAN_SECOND);
+}
+
+static void
+_upload_show_retry(struct upload_job_t *job, const char *const err, gint64 delay)
+{
+    HTTPUpload *upload = job->upload;
+
+    // logging is not thread safe, the ui lock keeps the main thread out of it
+    pthread_mutex_lock(&lock);
+    log_info("Upload of %s interrupted (%s), retry %d in %ds", upload->filename, err, job->attempts,
+        (int)(delay / G_TIME_SPAN_SECOND));
+
+    // canceled by closing the window, which may already have been freed
+    if (g_atomic_int_get(&upload->cancel)) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+
+    char *msg;
+    if (asprintf(&msg, "Uploading '%s': interrupted, retrying in %ds", upload->filename,
+            (int)(delay / G_TIME_SPAN_SECOND)) == -1) {
+        msg = strdup(FALLBACK_MSG);
+    }
+    win_update_entry_message(upload->window, upload->put_url, msg);
+    free(msg);
+    upload->progress_shown = -1;
+    pthread_mutex_unlock(&lock);
+}
+
+// with every upload backing off nothing is attached to the multi handle and curl_multi_wait
+// returns at once, so sleep until the first retry, a new upload that can start, or a cancel
+static void
+_upload_wait_retry(GSList *waiting, int active)
+{
+    gint64 earliest = G_MAXINT64;
+    GSList *curr = waiting;
+    while (curr) {
+        struct upload_job_t *job = curr->data;
+        earliest = MIN(earliest, job->retry_at);
+        curr = g_slist_next(curr);
+    }
+
+    gint64 delay = earliest - g_get_monotonic_time();
+    if (delay <= 0) {
+        return;
+    }
+    gint64 wake = g_get_real_time() + delay;
+    struct timespec until;
+    until.tv_sec = wake / G_USEC_PER_SEC;
+    until.tv_nsec = (wake % G_USEC_PER_SEC) * 1000;
+
+    pthread_mutex_lock(&queue_lock);
+    gboolean canceled = FALSE;
+    curr = waiting;
+    while (curr && !canceled) {
+        struct upload_job_t *job = curr->data;
+        canceled = g_atomic_int_get(&job->upload->cancel);
+        curr = g_slist_next(curr);
+    }
+    if (!canceled && (active >= max_active || g_queue_is_empty(queue))) {
+        pthread_cond_timedwait(&queue_cond, &queue_lock, &until);
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+
+static void*
+_upload_worker(void *userdata)
+{
+    int active = 0;
+    GSList *waiting = NULL;     // interrupted uploads waiting to retry, they keep their slot
+
+    while (TRUE) {
+        // take as many queued uploads as there are free transfer slots
+        GSList *starting = NULL;
+        pthread_mutex_lock(&queue_lock);
+        while (active == 0 && g_queue_is_empty(queue)) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+        int slots = max_active - active;
+        while (slots-- > 0 && !g_queue_is_empty(queue)) {
+            starting = g_slist_append(starting, g_queue_pop_head(queue));
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        // finishing an upload takes the ui lock, so never do it holding queue_lock
+        GSList *curr = starting;
+        while (curr) {
+            if (_upload_begin(curr->data)) {
+                active++;
+            }
+            curr = g_slist_next(curr);
+        }
+        g_slist_free(starting);
+
+        gint64 now = g_get_monotonic_time();
+        curr = waiting;
+        while (curr) {
+            struct upload_job_t *job = curr->data;
+            curr = g_slist_next(curr);
+            if (g_atomic_int_get(&job->upload->cancel)) {
+                waiting = g_slist_remove(waiting, job);
+                active--;
+                _upload_finish(job, strdup("canceled"));
+            } else if (job->retry_at <= now) {
+                waiting = g_slist_remove(waiting, job);
+                if (job->resume_from < job->map_size && job->upload->bytes_sent > (curl_off_t)job->resume_from) {
+                    _upload_probe(job);
+                } else {
+                    _upload_send(job);
+                }
+            }
+        }
+
+        if (active == 0) {
+            continue;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *info;
+        int remaining = 0;
+        while ((info = curl_multi_info_read(multi, &remaining))) {
+            if (info->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *curl = info->easy_handle;
+            CURLcode res = info->data.result;
+            struct upload_job_t *job = NULL;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&job);
+            curl_multi_remove_handle(multi, curl);
+
+            if (job->probing) {
+                job->resume_from = _upload_resume_offset(job, res);
+                _upload_send(job);
+                continue;
+            }
+
+            gboolean retry = FALSE;
+            char *err = _upload_result(job, res, &retry);
+            if (err && retry && job->attempts < UPLOAD_MAX_RETRIES && !g_atomic_int_get(&job->upload->cancel)) {
+                gint64 delay = _upload_retry_delay(job->attempts);
+                job->attempts++;
+                job->retry_at = g_get_monotonic_time() + delay;
+                _upload_show_retry(job, err, delay);
+                free(err);
+                waiting = g_slist_append(waiting, job);
+                continue;
+            }
+
+            active--;
+            _upload_finish(job, err);
+        }
+
+        if (active > 0 && g_slist_length(waiting) == (guint)active) {
+            _upload_wait_retry(waiting, active);
+        } else if (active > 0) {
+            curl_multi_wait(multi, NULL, 0, WORKER_WAIT_MS, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+void
+http_upload_start(HTTPUpload *upload)
+{
+    char* msg;
+    if (asprintf(&msg, "Uploading '%s': 0%%", upload->filename) == -1) {
+        msg = strdup(FALLBACK_MSG);
+    }
+    win_print_with_receipt(upload->window, '!', 0, NULL, 0, THEME_TEXT_ME, NULL, msg, upload->put_url);
+    free(msg);
+
+    upload_processes = g_slist_append(upload_processes, upload);
+
+    struct upload_job_t *job = calloc(1, sizeof(struct upload_job_t));
+    job->upload = upload;
+    job->cert_path = prefs_get_string(PREF_TLS_CERTPATH);
+
+    pthread_mutex_lock(&queue_lock);
+    max_active = prefs_get_upload_concurrency();
+    if (!worker_started) {
+        curl_global_init(CURL_GLOBAL_ALL);
+        multi = curl_multi_init();
+        queue = g_queue_new();
+        pthread_create(&worker, NULL, &_upload_worker, NULL);
+        worker_started = TRUE;
+    }
+    g_queue_push_tail(queue, job);
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+void
+http_upload_cancel(HTTPUpload *upload)
+{
+    // wakes the upload thread if it is sleeping until a retry
+    pthread_mutex_lock(&queue_lock);
+    g_atomic_int_set(&upload->cancel, 1);
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+void
+http_upload_set_concurrency(int count)
+{
+    // takes effect on the next pass of the upload thread
+    pthread_mutex_lock(&queue_lock);
+    max_active = count;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+gboolean
+file_upload_info(const char *const file_name, off_t *size, char **mime_type)
+{
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1) {
+        return FALSE;
+    }
+
     struct stat st;
-    stat(filename, &st);
-    return st.st_size;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return FALSE;
+    }
+    *size = st.st_size;
+
+    unsigned char file_header[FILE_HEADER_BYTES];
+    ssize_t file_header_size = read(fd, file_header, FILE_HEADER_BYTES);
+    close(fd);
+    if (file_header_size < 0) {
+        file_header_size = 0;
+    }
+
+    char *content_type = g_content_type_guess(file_name, file_header, file_header_size, NULL);
+    char *guessed = content_type ? g_content_type_get_mime_type(content_type) : NULL;
+    *mime_type = strdup(guessed ? guessed : FALLBACK_MIMETYPE);
+    g_free(guessed);
+    g_free(content_type);
+
+    return TRUE;
 }
 
 int is_regular_file(const char *filename)
@@ -41,6 +41,7 @@
 
 #include <sys/select.h>
 #include <curl/curl.h>
+#include <glib.h>
 
 #include "ui/win_types.h"
 
@@ -52,16 +53,19 @@ typedef struct http_upload_t {
     char *get_url;
     char *put_url;
     ProfWin *window;
-    pthread_t worker;
-    int cancel;
+    volatile gint cancel;
+    volatile gint progress;    // percent sent, published by the worker
+    int progress_shown;        // percent last shown, guarded by the ui lock
 } HTTPUpload;
 
 GSList *upload_processes;
 
-void* http_file_put(void *userdata);
+void http_upload_start(HTTPUpload *upload);
+void http_upload_cancel(HTTPUpload *upload);
+void http_upload_check(void);
+void http_upload_set_concurrency(int count);
 
-char* file_mime_type(const char* const file_name);
-off_t file_size(const char* const file_name);
+gboolean file_upload_info(const char *const file_name, off_t *size, char **mime_type);
 int is_regular_file(const char *filename);
 
 #endif
@@ -0,0 +1,138 @@
+/*
+ * intern.c
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tools/intern.h"
+
+typedef struct intern_entry_t {
+    int refcount;
+    char str[];
+} InternEntry;
+
+#define ENTRY_FROM_STR(s) ((InternEntry*)((char*)(s) - offsetof(InternEntry, str)))
+
+// entries by their string, the key is the entry's own str
+static GHashTable *pool = NULL;
+
+static gsize pool_bytes = 0;
+static gulong pool_refs = 0;
+static gulong pool_lookups = 0;
+static gulong pool_hits = 0;
+
+char*
+intern_ref(const char *const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    if (pool == NULL) {
+        pool = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+
+    pool_lookups++;
+    pool_refs++;
+
+    InternEntry *entry = g_hash_table_lookup(pool, str);
+    if (entry) {
+        pool_hits++;
+        entry->refcount++;
+        return entry->str;
+    }
+
+    size_t len = strlen(str);
+    entry = malloc(sizeof(InternEntry) + len + 1);
+    entry->refcount = 1;
+    memcpy(entry->str, str, len + 1);
+    g_hash_table_insert(pool, entry->str, entry);
+    pool_bytes += len + 1;
+
+    return entry->str;
+}
+
+void
+intern_unref(const char *const str)
+{
+    if (str == NULL) {
+        return;
+    }
+
+    InternEntry *entry = ENTRY_FROM_STR(str);
+    pool_refs--;
+    entry->refcount--;
+    if (entry->refcount > 0) {
+        return;
+    }
+
+    if (pool) {
+        g_hash_table_remove(pool, entry->str);
+    }
+    pool_bytes -= strlen(entry->str) + 1;
+    free(entry);
+}
+
+guint
+intern_get_count(void)
+{
+    return pool ? g_hash_table_size(pool) : 0;
+}
+
+gsize
+intern_get_bytes(void)
+{
+    return pool_bytes;
+}
+
+gulong
+intern_get_refs(void)
+{
+    return pool_refs;
+}
+
+gulong
+intern_get_lookups(void)
+{
+    return pool_lookups;
+}
+
+gulong
+intern_get_hits(void)
+{
+    return pool_hits;
+}
@@ -0,0 +1,246 @@
+/*
+ * matcher.c
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tools/matcher.h"
+
+// Aho-Corasick automaton over bytes, nodes and patterns are referenced by index
+
+typedef struct matcher_edge_t {
+    unsigned char byte;
+    int target;
+} MatcherEdge;
+
+typedef struct matcher_node_t {
+    GArray *edges;
+    int fail;
+    int output; // last pattern ending at this node, or -1
+    int dict;   // nearest node on the fail chain with an output, or -1
+} MatcherNode;
+
+typedef struct matcher_pattern_t {
+    int len;
+    int next_same; // previously added identical pattern, or -1
+} MatcherPattern;
+
+struct matcher_t {
+    GArray *nodes;
+    GArray *patterns;
+    gboolean compiled;
+};
+
+static int _matcher_node_new(Matcher matcher);
+static int _matcher_child(Matcher matcher, int node, unsigned char byte);
+
+Matcher
+matcher_new(void)
+{
+    Matcher matcher = malloc(sizeof(struct matcher_t));
+    matcher->nodes = g_array_new(FALSE, FALSE, sizeof(MatcherNode));
+    matcher->patterns = g_array_new(FALSE, FALSE, sizeof(MatcherPattern));
+    matcher->compiled = FALSE;
+
+    // root
+    _matcher_node_new(matcher);
+
+    return matcher;
+}
+
+void
+matcher_free(Matcher matcher)
+{
+    if (matcher == NULL) {
+        return;
+    }
+
+    guint i;
+    for (i = 0; i < matcher->nodes->len; i++) {
+        MatcherNode *node = &g_array_index(matcher->nodes, MatcherNode, i);
+        g_array_free(node->edges, TRUE);
+    }
+    g_array_free(matcher->nodes, TRUE);
+    g_array_free(matcher->patterns, TRUE);
+    free(matcher);
+}
+
+int
+matcher_add(Matcher matcher, const char *const pattern)
+{
+    MatcherPattern entry;
+    entry.len = pattern ? strlen(pattern) : 0;
+    entry.next_same = -1;
+    int index = matcher->patterns->len;
+
+    // empty patterns are kept so indexes stay stable, but never match
+    if (entry.len == 0) {
+        g_array_append_val(matcher->patterns, entry);
+        return index;
+    }
+
+    int curr = 0;
+    int i;
+    for (i = 0; i < entry.len; i++) {
+        unsigned char byte = pattern[i];
+        int next = _matcher_child(matcher, curr, byte);
+        if (next == -1) {
+            next = _matcher_node_new(matcher);
+            MatcherEdge edge = { byte, next };
+            g_array_append_val(g_array_index(matcher->nodes, MatcherNode, curr).edges, edge);
+        }
+        curr = next;
+    }
+
+    MatcherNode *node = &g_array_index(matcher->nodes, MatcherNode, curr);
+    entry.next_same = node->output;
+    node->output = index;
+    g_array_append_val(matcher->patterns, entry);
+
+    matcher->compiled = FALSE;
+
+    return index;
+}
+
+void
+matcher_compile(Matcher matcher)
+{
+    // breadth first, so fail links always point to nodes already done
+    GQueue *queue = g_queue_new();
+
+    MatcherNode *root = &g_array_index(matcher->nodes, MatcherNode, 0);
+    guint i;
+    for (i = 0; i < root->edges->len; i++) {
+        int child = g_array_index(root->edges, MatcherEdge, i).target;
+        MatcherNode *child_node = &g_array_index(matcher->nodes, MatcherNode, child);
+        child_node->fail = 0;
+        child_node->dict = -1;
+        g_queue_push_tail(queue, GINT_TO_POINTER(child));
+    }
+
+    while (!g_queue_is_empty(queue)) {
+        int curr = GPOINTER_TO_INT(g_queue_pop_head(queue));
+        MatcherNode *node = &g_array_index(matcher->nodes, MatcherNode, curr);
+
+        for (i = 0; i < node->edges->len; i++) {
+            MatcherEdge edge = g_array_index(node->edges, MatcherEdge, i);
+
+            int fail = node->fail;
+            int fail_child = _matcher_child(matcher, fail, edge.byte);
+            while (fail_child == -1 && fail != 0) {
+                fail = g_array_index(matcher->nodes, MatcherNode, fail).fail;
+                fail_child = _matcher_child(matcher, fail, edge.byte);
+            }
+
+            MatcherNode *target = &g_array_index(matcher->nodes, MatcherNode, edge.target);
+            target->fail = fail_child == -1 ? 0 : fail_child;
+
+            MatcherNode *fail_node = &g_array_index(matcher->nodes, MatcherNode, target->fail);
+            target->dict = fail_node->output != -1 ? target->fail : fail_node->dict;
+
+            g_queue_push_tail(queue, GINT_TO_POINTER(edge.target));
+        }
+    }
+
+    g_queue_free(queue);
+    matcher->compiled = TRUE;
+}
+
+void
+matcher_scan(Matcher matcher, const char *const text, matcher_func func, void *userdata)
+{
+    if (text == NULL) {
+        return;
+    }
+
+    if (!matcher->compiled) {
+        matcher_compile(matcher);
+    }
+
+    int state = 0;
+    int i;
+    for (i = 0; text[i] != '\0'; i++) {
+        unsigned char byte = text[i];
+
+        int next = _matcher_child(matcher, state, byte);
+        while (next == -1 && state != 0) {
+            state = g_array_index(matcher->nodes, MatcherNode, state).fail;
+            next = _matcher_child(matcher, state, byte);
+        }
+        state = next == -1 ? 0 : next;
+
+        int out = g_array_index(matcher->nodes, MatcherNode, state).output != -1 ?
+            state : g_array_index(matcher->nodes, MatcherNode, state).dict;
+        while (out != -1) {
+            MatcherNode *out_node = &g_array_index(matcher->nodes, MatcherNode, out);
+            int pattern = out_node->output;
+            while (pattern != -1) {
+                MatcherPattern *entry = &g_array_index(matcher->patterns, MatcherPattern, pattern);
+                func(pattern, i + 1 - entry->len, userdata);
+                pattern = entry->next_same;
+            }
+            out = out_node->dict;
+        }
+    }
+}
+
+static int
+_matcher_node_new(Matcher matcher)
+{
+    MatcherNode node;
+    node.edges = g_array_new(FALSE, FALSE, sizeof(MatcherEdge));
+    node.fail = 0;
+    node.output = -1;
+    node.dict = -1;
+    g_array_append_val(matcher->nodes, node);
+
+    return matcher->nodes->len - 1;
+}
+
+static int
+_matcher_child(Matcher matcher, int node, unsigned char byte)
+{
+    GArray *edges = g_array_index(matcher->nodes, MatcherNode, node).edges;
+    guint i;
+    for (i = 0; i < edges->len; i++) {
+        MatcherEdge *edge = &g_array_index(edges, MatcherEdge, i);
+        if (edge->byte == byte) {
+            return edge->target;
+        }
+    }
+
+    return -1;
+}
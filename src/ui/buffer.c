@@ -48,107 +48,186 @@
 
 #include "ui/window.h"
 #include "ui/buffer.h"
+#include "tools/intern.h"
 
 #define BUFF_SIZE 1200
 
+// entries are kept in a ring that grows up to BUFF_SIZE, after which
+// the oldest entry is replaced
 struct prof_buff_t {
-    GSList *entries;
+    ProfBuffEntry **entries;
+    int capacity;
+    int start;
+    int count;
 };
 
+static ProfBuffEntry* _entry_new(const char show_char, int pad_indent, gint64 time, int flags,
+    theme_item_t theme_item, const char *const from, const char *const message, const char *const receipt_id);
 static void _free_entry(ProfBuffEntry *entry);
+static int _index_of_id(ProfBuff buffer, const char *const id);
 
 ProfBuff
 buffer_create(void)
 {
     ProfBuff new_buff = malloc(sizeof(struct prof_buff_t));
     new_buff->entries = NULL;
+    new_buff->capacity = 0;
+    new_buff->start = 0;
+    new_buff->count = 0;
     return new_buff;
 }
 
 int
 buffer_size(ProfBuff buffer)
 {
-    return g_slist_length(buffer->entries);
+    return buffer->count;
 }
 
 void
 buffer_free(ProfBuff buffer)
 {
-    g_slist_free_full(buffer->entries, (GDestroyNotify)_free_entry);
+    int i;
+    for (i = 0; i < buffer->count; i++) {
+        _free_entry(buffer_yield_entry(buffer, i));
+    }
+    free(buffer->entries);
     free(buffer);
 }
 
 void
-buffer_push(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *time,
-    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt)
+buffer_push(ProfBuff buffer, const char show_char, int pad_indent, gint64 time,
+    int flags, theme_item_t theme_item, const char *const from, const char *const message, const char *const receipt_id)
 {
-    ProfBuffEntry *e = malloc(sizeof(struct prof_buff_entry_t));
-    e->show_char = show_char;
-    e->pad_indent = pad_indent;
-    e->flags = flags;
-    e->theme_item = theme_item;
-    e->time = g_date_time_ref(time);
-    e->from = from ? strdup(from) : NULL;
-    e->message = strdup(message);
-    e->receipt = receipt;
-
-    if (g_slist_length(buffer->entries) == BUFF_SIZE) {
-        _free_entry(buffer->entries->data);
-        buffer->entries = g_slist_delete_link(buffer->entries, buffer->entries);
+    ProfBuffEntry *e = _entry_new(show_char, pad_indent, time, flags, theme_item, from, message, receipt_id);
+
+    if (buffer->count == BUFF_SIZE) {
+        _free_entry(buffer->entries[buffer->start]);
+        buffer->entries[buffer->start] = e;
+        buffer->start = (buffer->start + 1) % BUFF_SIZE;
+        return;
+    }
+
+    if (buffer->count == buffer->capacity) {
+        buffer->capacity = buffer->capacity == 0 ? 16 : MIN(buffer->capacity * 2, BUFF_SIZE);
+        buffer->entries = realloc(buffer->entries, buffer->capacity * sizeof(ProfBuffEntry*));
     }
 
-    buffer->entries = g_slist_append(buffer->entries, e);
+    buffer->entries[buffer->count++] = e;
 }
 
 gboolean
 buffer_mark_received(ProfBuff buffer, const char *const id)
 {
-    GSList *entries = buffer->entries;
-    while (entries) {
-        ProfBuffEntry *entry = entries->data;
-        if (entry->receipt && g_strcmp0(entry->receipt->id, id) == 0) {
-            if (!entry->receipt->received) {
-                entry->receipt->received = TRUE;
+    int i;
+    for (i = 0; i < buffer->count; i++) {
+        ProfBuffEntry *entry = buffer_yield_entry(buffer, i);
+        const char *entry_id = buffer_entry_receipt_id(entry);
+        if (entry_id && g_strcmp0(entry_id, id) == 0) {
+            if (!entry->received) {
+                entry->received = TRUE;
                 return TRUE;
             }
         }
-        entries = g_slist_next(entries);
     }
 
     return FALSE;
 }
 
+gboolean
+buffer_update_message(ProfBuff buffer, const char *const id, const char *const message)
+{
+    int i = _index_of_id(buffer, id);
+    if (i < 0) {
+        return FALSE;
+    }
+
+    int slot = (buffer->start + i) % buffer->capacity;
+    ProfBuffEntry *old = buffer->entries[slot];
+    ProfBuffEntry *e = _entry_new(old->show_char, old->pad_indent, old->time, old->flags, old->theme_item,
+        old->from, message, id);
+    e->received = old->received;
+    buffer->entries[slot] = e;
+    _free_entry(old);
+
+    return TRUE;
+}
+
 ProfBuffEntry*
 buffer_yield_entry(ProfBuff buffer, int entry)
 {
-    GSList *node = g_slist_nth(buffer->entries, entry);
-    return node->data;
+    return buffer->entries[(buffer->start + entry) % buffer->capacity];
 }
 
 ProfBuffEntry*
 buffer_yield_entry_by_id(ProfBuff buffer, const char *const id)
 {
-    GSList *entries = buffer->entries;
-    while (entries) {
-        ProfBuffEntry *entry = entries->data;
-        if (entry->receipt && g_strcmp0(entry->receipt->id, id) == 0) {
-            return entry;
+    int i = _index_of_id(buffer, id);
+    if (i < 0) {
+        return NULL;
+    }
+
+    return buffer_yield_entry(buffer, i);
+}
+
+const char*
+buffer_entry_receipt_id(ProfBuffEntry *entry)
+{
+    if (entry->id_offset == 0) {
+        return NULL;
+    }
+
+    return entry->message + entry->id_offset;
+}
+
+gboolean
+buffer_entry_receipt_pending(ProfBuffEntry *entry)
+{
+    return entry->id_offset != 0 && !entry->received;
+}
+
+static ProfBuffEntry*
+_entry_new(const char show_char, int pad_indent, gint64 time, int flags, theme_item_t theme_item,
+    const char *const from, const char *const message, const char *const receipt_id)
+{
+    size_t message_len = strlen(message) + 1;
+    size_t id_len = receipt_id ? strlen(receipt_id) + 1 : 0;
+
+    ProfBuffEntry *e = malloc(sizeof(ProfBuffEntry) + message_len + id_len);
+    e->show_char = show_char;
+    e->pad_indent = pad_indent;
+    e->flags = flags;
+    e->theme_item = theme_item;
+    e->time = time;
+    e->received = FALSE;
+    e->from = intern_ref(from);
+    memcpy(e->message, message, message_len);
+    if (receipt_id) {
+        e->id_offset = message_len;
+        memcpy(e->message + message_len, receipt_id, id_len);
+    } else {
+        e->id_offset = 0;
+    }
+
+    return e;
+}
+
+static int
+_index_of_id(ProfBuff buffer, const char *const id)
+{
+    int i;
+    for (i = 0; i < buffer->count; i++) {
+        const char *entry_id = buffer_entry_receipt_id(buffer_yield_entry(buffer, i));
+        if (entry_id && g_strcmp0(entry_id, id) == 0) {
+            return i;
         }
-        entries = g_slist_next(entries);
     }
 
-    return NULL;
+    return -1;
 }
 
 static void
 _free_entry(ProfBuffEntry *entry)
 {
-    free(entry->message);
-    free(entry->from);
-    g_date_time_unref(entry->time);
-    if (entry->receipt) {
-        free(entry->receipt->id);
-        free(entry->receipt);
-    }
+    intern_unref(entry->from);
     free(entry);
 }
@@ -40,31 +40,33 @@
 #include "config.h"
 #include "config/theme.h"
 
-typedef struct delivery_receipt_t {
-    char *id;
-    gboolean received;
-} DeliveryReceipt;
-
+// a buffered line is a single allocation, the message text is stored inline
+// followed by the receipt id when the line expects a delivery receipt
 typedef struct prof_buff_entry_t {
-    char show_char;
-    int pad_indent;
-    GDateTime *time;
+    gint64 time;
     int flags;
     theme_item_t theme_item;
+    int pad_indent;
+    char show_char;
+    gboolean received;
+    unsigned int id_offset;
     char *from;
-    char *message;
-    DeliveryReceipt *receipt;
+    char message[];
 } ProfBuffEntry;
 
 typedef struct prof_buff_t *ProfBuff;
 
 ProfBuff buffer_create();
 void buffer_free(ProfBuff buffer);
-void buffer_push(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *time, int flags, theme_item_t theme_item,
-    const char *const from, const char *const message, DeliveryReceipt *receipt);
+void buffer_push(ProfBuff buffer, const char show_char, int pad_indent, gint64 time, int flags, theme_item_t theme_item,
+    const char *const from, const char *const message, const char *const receipt_id);
 int buffer_size(ProfBuff buffer);
 ProfBuffEntry* buffer_yield_entry(ProfBuff buffer, int entry);
 ProfBuffEntry* buffer_yield_entry_by_id(ProfBuff buffer, const char *const id);
 gboolean buffer_mark_received(ProfBuff buffer, const char *const id);
+gboolean buffer_update_message(ProfBuff buffer, const char *const id, const char *const message);
+
+const char* buffer_entry_receipt_id(ProfBuffEntry *entry);
+gboolean buffer_entry_receipt_pending(ProfBuffEntry *entry);
 
 #endif
@@ -236,6 +236,7 @@ chatwin_incoming_msg(ProfChatWin *chatwin, const char *const resource, const cha
     assert(chatwin != NULL);
 
     char *plugin_message = plugins_pre_chat_message_display(chatwin->barejid, resource, message);
+    const char *display_message = plugin_message ? plugin_message : message;
 
     ProfWin *window = (ProfWin*)chatwin;
     int num = wins_get_num(window);
@@ -247,7 +248,7 @@ chatwin_incoming_msg(ProfChatWin *chatwin, const char *const resource, const cha
 
     // currently viewing chat window with sender
     if (wins_is_current(window)) {
-        win_print_incoming_message(window, timestamp, display_name, plugin_message, enc_mode);
+        win_print_incoming_message(window, timestamp, display_name, display_message, enc_mode);
         title_bar_set_typing(FALSE);
         status_bar_active(num);
 
@@ -274,7 +275,7 @@ chatwin_incoming_msg(ProfChatWin *chatwin, const char *const resource, const cha
             }
         }
 
-        win_print_incoming_message(window, timestamp, display_name, plugin_message, enc_mode);
+        win_print_incoming_message(window, timestamp, display_name, display_message, enc_mode);
     }
 
     if (prefs_get_boolean(PREF_BEEP)) {
@@ -282,12 +283,12 @@ chatwin_incoming_msg(ProfChatWin *chatwin, const char *const resource, const cha
     }
 
     if (notify) {
-        notify_message(display_name, num, plugin_message);
+        notify_message(display_name, num, display_message);
     }
 
     free(display_name);
 
-    plugins_post_chat_message_display(chatwin->barejid, resource, plugin_message);
+    plugins_post_chat_message_display(chatwin->barejid, resource, display_message);
 
     free(plugin_message);
 }
@@ -1534,7 +1534,7 @@ cons_show_ui_prefs(void)
     cons_beep_setting();
     cons_flash_setting();
     cons_splash_setting();
-    cons_winpos_setting();
+    cons_statusbar_setting();
     cons_wrap_setting();
     cons_winstidy_setting();
     cons_time_setting();
@@ -1763,6 +1763,20 @@ cons_winpos_setting(void)
     prefs_free_win_placement(placement);
 }
 
+void
+cons_statusbar_setting(void)
+{
+    cons_winpos_setting();
+
+    char *mode = prefs_get_string(PREF_STATUSBAR_MODE);
+    cons_show("Status bar mode (/statusbar)        : %s", mode);
+    prefs_free_string(mode);
+
+    char *sort = prefs_get_string(PREF_STATUSBAR_SORT);
+    cons_show("Status bar sort (/statusbar)        : %s", sort);
+    prefs_free_string(sort);
+}
+
 void
 cons_log_setting(void)
 {
@@ -1911,6 +1925,12 @@ cons_autoping_setting(void)
     }
 }
 
+void
+cons_upload_setting(void)
+{
+    cons_show("Upload concurrency (/upload)    : %d", prefs_get_upload_concurrency());
+}
+
 void
 cons_show_connection_prefs(void)
 {
@@ -1918,6 +1938,7 @@ cons_show_connection_prefs(void)
     cons_show("");
     cons_reconnect_setting();
     cons_autoping_setting();
+    cons_upload_setting();
     cons_autoconnect_setting();
 
     cons_alert();
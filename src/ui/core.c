@@ -62,6 +62,7 @@
 #include "command/cmd_ac.h"
 #include "config/preferences.h"
 #include "config/theme.h"
+#include "event/server_events.h"
 #include "ui/ui.h"
 #include "ui/titlebar.h"
 #include "ui/statusbar.h"
@@ -496,6 +497,7 @@ ui_close_connected_win(int index)
             assert(mucwin->memcheck == PROFMUCWIN_MEMCHECK);
             presence_leave_chat_room(mucwin->roomjid);
             muc_leave(mucwin->roomjid);
+            sv_ev_room_matcher_remove(mucwin->roomjid);
             ui_leave_room(mucwin->roomjid);
         } else if (window->type == WIN_CHAT) {
             ProfChatWin *chatwin = (ProfChatWin*) window;
@@ -337,28 +337,39 @@ mucwin_nick_change(ProfMucWin *mucwin, const char *const nick)
 }
 
 void
-mucwin_history(ProfMucWin *mucwin, const char *const nick, GDateTime *timestamp, const char *const message)
+mucwin_history(ProfMucWin *mucwin, GList *history)
 {
     assert(mucwin != NULL);
 
     ProfWin *window = (ProfWin*)mucwin;
     GString *line = g_string_new("");
 
-    if (strncmp(message, "/me ", 4) == 0) {
-        g_string_append(line, "*");
-        g_string_append(line, nick);
-        g_string_append(line, " ");
-        g_string_append(line, message + 4);
-    } else {
-        g_string_append(line, nick);
-        g_string_append(line, ": ");
-        g_string_append(line, message);
-    }
+    GList *curr = history;
+    while (curr) {
+        MucHistory *entry = curr->data;
+        g_string_truncate(line, 0);
+        if (strncmp(entry->message, "/me ", 4) == 0) {
+            g_string_append(line, "*");
+            g_string_append(line, entry->nick);
+            g_string_append(line, " ");
+            g_string_append(line, entry->message + 4);
+        } else {
+            g_string_append(line, entry->nick);
+            g_string_append(line, ": ");
+            g_string_append(line, entry->message);
+        }
 
-    win_print(window, '-', 0, timestamp, NO_COLOUR_DATE, 0, "", line->str);
+        win_print_deferred(window, '-', 0, entry->timestamp, NO_COLOUR_DATE, 0, "", line->str);
+        curr = g_list_next(curr);
+    }
     g_string_free(line, TRUE);
 
-    plugins_on_room_history_message(mucwin->roomjid, nick, message, timestamp);
+    if (wins_is_current(window)) {
+        win_render_pending(window);
+    }
+    inp_nonblocking(TRUE);
+
+    plugins_on_room_history_messages(mucwin->roomjid, history);
 }
 
 static void
@@ -66,10 +66,26 @@ static GTimeZone *tz;
 static GDateTime *last_time;
 static int current;
 
+// activity mode, only windows with new messages are shown
+static gboolean activity_mode;
+static gboolean activity_by_recent;
+static GHashTable *activity;
+static guint activity_seq;
+static int activity_last;
+static int activity_width;
+static int current_num;
+
+static void _load_mode(void);
+static void _erase(void);
+static void _draw_win_indicators(void);
 static void _update_win_statuses(void);
+static void _update_win_status(int num);
 static void _mark_new(int num);
 static void _mark_active(int num);
 static void _mark_inactive(int num);
+static gboolean _activity_add(int num);
+static gboolean _activity_remove(int num);
+static void _activity_draw(void);
 static void _status_bar_draw(void);
 
 void
@@ -86,17 +102,19 @@ create_status_bar(void)
     }
     remaining_active = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
     remaining_new = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+    activity = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+    activity_seq = 0;
+    activity_last = 0;
+    activity_width = 0;
     current = 1;
+    current_num = 1;
 
-    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
+    _load_mode();
 
     int row = screen_statusbar_row();
     status_bar = newwin(1, cols, row, 0);
     wbkgd(status_bar, theme_attrs(THEME_STATUS_TEXT));
-    wattron(status_bar, bracket_attrs);
-    mvwprintw(status_bar, 0, cols - 34, _active);
-    mvwprintw(status_bar, 0, cols - 34 + ((current - 1) * 3), bracket);
-    wattroff(status_bar, bracket_attrs);
+    _draw_win_indicators();
 
     tz = g_time_zone_new_local();
 
@@ -119,18 +137,14 @@ status_bar_resize(void)
 {
     int cols = getmaxx(stdscr);
 
-    werase(status_bar);
-
-    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
+    _erase();
+    _load_mode();
 
     int row = screen_statusbar_row();
     mvwin(status_bar, row, 0);
     wresize(status_bar, 1, cols);
     wbkgd(status_bar, theme_attrs(THEME_STATUS_TEXT));
-    wattron(status_bar, bracket_attrs);
-    mvwprintw(status_bar, 0, cols - 34, _active);
-    mvwprintw(status_bar, 0, cols - 34 + ((current - 1) * 3), bracket);
-    wattroff(status_bar, bracket_attrs);
+    _draw_win_indicators();
 
     if (message) {
         char *time_pref = prefs_get_string(PREF_TIME_STATUSBAR);
@@ -168,12 +182,14 @@ status_bar_set_all_inactive(void)
     for (i = 0; i < 12; i++) {
         is_active[i] = FALSE;
         is_new[i] = FALSE;
-        _mark_inactive(i);
     }
 
     g_hash_table_remove_all(remaining_active);
     g_hash_table_remove_all(remaining_new);
+    g_hash_table_remove_all(activity);
+    activity_last = 0;
 
+    _draw_win_indicators();
     _status_bar_draw();
 }
 
@@ -187,13 +203,14 @@ status_bar_current(int i)
     } else {
         current = i;
     }
-    int cols = getmaxx(stdscr);
-    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
-    wattron(status_bar, bracket_attrs);
-    mvwprintw(status_bar, 0, cols - 34, _active);
-    mvwprintw(status_bar, 0, cols - 34 + ((current - 1) * 3), bracket);
-    wattroff(status_bar, bracket_attrs);
 
+    if (i == 0) {
+        current_num = 10;
+    } else {
+        current_num = i;
+    }
+
+    _draw_win_indicators();
     _status_bar_draw();
 }
 
@@ -205,6 +222,8 @@ status_bar_inactive(const int win)
         true_win = 10;
     }
 
+    int slot = true_win;
+
     // extra windows
     if (true_win > 10) {
         g_hash_table_remove(remaining_active, GINT_TO_POINTER(true_win));
@@ -214,26 +233,32 @@ status_bar_inactive(const int win)
         if (g_hash_table_size(remaining_new) != 0) {
             is_active[11] = TRUE;
             is_new[11] = TRUE;
-            _mark_new(11);
 
         // still have active windows
         } else if (g_hash_table_size(remaining_active) != 0) {
             is_active[11] = TRUE;
             is_new[11] = FALSE;
-            _mark_active(11);
 
         // no active or new windows
         } else {
             is_active[11] = FALSE;
             is_new[11] = FALSE;
-            _mark_inactive(11);
         }
+        slot = 11;
 
     // visible window indicators
     } else {
         is_active[true_win] = FALSE;
         is_new[true_win] = FALSE;
-        _mark_inactive(true_win);
+    }
+
+    gboolean changed = _activity_remove(true_win);
+    if (activity_mode) {
+        if (changed) {
+            _activity_draw();
+        }
+    } else {
+        _update_win_status(slot);
     }
 
     _status_bar_draw();
@@ -247,6 +272,8 @@ status_bar_active(const int win)
         true_win = 10;
     }
 
+    int slot = true_win;
+
     // extra windows
     if (true_win > 10) {
         g_hash_table_add(remaining_active, GINT_TO_POINTER(true_win));
@@ -256,20 +283,27 @@ status_bar_active(const int win)
         if (g_hash_table_size(remaining_new) != 0) {
             is_active[11] = TRUE;
             is_new[11] = TRUE;
-            _mark_new(11);
 
         // only active windows
         } else {
             is_active[11] = TRUE;
             is_new[11] = FALSE;
-            _mark_active(11);
         }
+        slot = 11;
 
     // visible window indicators
     } else {
         is_active[true_win] = TRUE;
         is_new[true_win] = FALSE;
-        _mark_active(true_win);
+    }
+
+    gboolean changed = _activity_remove(true_win);
+    if (activity_mode) {
+        if (changed) {
+            _activity_draw();
+        }
+    } else {
+        _update_win_status(slot);
     }
 
     _status_bar_draw();
@@ -283,18 +317,28 @@ status_bar_new(const int win)
         true_win = 10;
     }
 
+    int slot = true_win;
+
     if (true_win > 10) {
         g_hash_table_add(remaining_active, GINT_TO_POINTER(true_win));
         g_hash_table_add(remaining_new, GINT_TO_POINTER(true_win));
 
         is_active[11] = TRUE;
         is_new[11] = TRUE;
-        _mark_new(11);
+        slot = 11;
 
     } else {
         is_active[true_win] = TRUE;
         is_new[true_win] = TRUE;
-        _mark_new(true_win);
+    }
+
+    gboolean changed = _activity_add(true_win);
+    if (activity_mode) {
+        if (changed) {
+            _activity_draw();
+        }
+    } else {
+        _update_win_status(slot);
     }
 
     _status_bar_draw();
@@ -311,7 +355,7 @@ status_bar_get_password(void)
 void
 status_bar_print_message(const char *const msg)
 {
-    werase(status_bar);
+    _erase();
 
     if (message) {
         free(message);
@@ -336,14 +380,7 @@ status_bar_print_message(const char *const msg)
     }
     prefs_free_string(time_pref);
 
-    int cols = getmaxx(stdscr);
-    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
-
-    wattron(status_bar, bracket_attrs);
-    mvwprintw(status_bar, 0, cols - 34, _active);
-    mvwprintw(status_bar, 0, cols - 34 + ((current - 1) * 3), bracket);
-    wattroff(status_bar, bracket_attrs);
-
+    _draw_win_indicators();
     _status_bar_draw();
 }
 
@@ -355,16 +392,8 @@ status_bar_clear(void)
         message = NULL;
     }
 
-    werase(status_bar);
-
-    int cols = getmaxx(stdscr);
-    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
-
-    wattron(status_bar, bracket_attrs);
-    mvwprintw(status_bar, 0, cols - 34, _active);
-    mvwprintw(status_bar, 0, cols - 34 + ((current - 1) * 3), bracket);
-    wattroff(status_bar, bracket_attrs);
-
+    _erase();
+    _draw_win_indicators();
     _status_bar_draw();
 }
 
@@ -376,7 +405,37 @@ status_bar_clear_message(void)
         message = NULL;
     }
 
+    _erase();
+    _draw_win_indicators();
+    _status_bar_draw();
+}
+
+static void
+_load_mode(void)
+{
+    char *mode = prefs_get_string(PREF_STATUSBAR_MODE);
+    activity_mode = g_strcmp0(mode, "activity") == 0;
+    prefs_free_string(mode);
+
+    char *sort = prefs_get_string(PREF_STATUSBAR_SORT);
+    activity_by_recent = g_strcmp0(sort, "recent") == 0;
+    prefs_free_string(sort);
+}
+
+static void
+_erase(void)
+{
     werase(status_bar);
+    activity_width = 0;
+}
+
+static void
+_draw_win_indicators(void)
+{
+    if (activity_mode) {
+        _activity_draw();
+        return;
+    }
 
     int cols = getmaxx(stdscr);
     int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
@@ -386,7 +445,7 @@ status_bar_clear_message(void)
     mvwprintw(status_bar, 0, cols - 34 + ((current - 1) * 3), bracket);
     wattroff(status_bar, bracket_attrs);
 
-    _status_bar_draw();
+    _update_win_statuses();
 }
 
 static void
@@ -394,15 +453,21 @@ _update_win_statuses(void)
 {
     int i;
     for(i = 1; i < 12; i++) {
-        if (is_new[i]) {
-            _mark_new(i);
-        }
-        else if (is_active[i]) {
-            _mark_active(i);
-        }
-        else {
-            _mark_inactive(i);
-        }
+        _update_win_status(i);
+    }
+}
+
+static void
+_update_win_status(int num)
+{
+    if (is_new[num]) {
+        _mark_new(num);
+    }
+    else if (is_active[num]) {
+        _mark_active(num);
+    }
+    else {
+        _mark_inactive(num);
     }
 }
 
@@ -450,6 +515,155 @@ _mark_inactive(int num)
     mvwaddch(status_bar, 0, cols - 34 + active_pos, ' ');
 }
 
+// returns TRUE if the activity indicators need to be redrawn
+static gboolean
+_activity_add(int num)
+{
+    gboolean existed = g_hash_table_contains(activity, GINT_TO_POINTER(num));
+    g_hash_table_replace(activity, GINT_TO_POINTER(num), GUINT_TO_POINTER(++activity_seq));
+
+    gboolean changed = !existed || (activity_by_recent && activity_last != num);
+    activity_last = num;
+
+    return changed;
+}
+
+// returns TRUE if the activity indicators need to be redrawn
+static gboolean
+_activity_remove(int num)
+{
+    if (activity_last == num) {
+        activity_last = 0;
+    }
+
+    return g_hash_table_remove(activity, GINT_TO_POINTER(num));
+}
+
+static gint
+_activity_cmp(gconstpointer a, gconstpointer b)
+{
+    if (activity_by_recent) {
+        guint seq_a = GPOINTER_TO_UINT(g_hash_table_lookup(activity, a));
+        guint seq_b = GPOINTER_TO_UINT(g_hash_table_lookup(activity, b));
+        if (seq_a > seq_b) {
+            return -1;
+        } else if (seq_a < seq_b) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }
+
+    return GPOINTER_TO_INT(a) - GPOINTER_TO_INT(b);
+}
+
+static int
+_activity_item_width(int num)
+{
+    char buf[16];
+    return snprintf(buf, sizeof(buf), "%d", num) + 2;
+}
+
+static int
+_activity_print(int pos, int num, gboolean is_current)
+{
+    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
+    gboolean is_new_win = g_hash_table_contains(activity, GINT_TO_POINTER(num));
+
+    wattron(status_bar, bracket_attrs);
+    mvwaddch(status_bar, 0, pos++, is_current ? '-' : '[');
+    wattroff(status_bar, bracket_attrs);
+
+    if (is_new_win) {
+        int status_attrs = theme_attrs(THEME_STATUS_NEW);
+        wattron(status_bar, status_attrs);
+        wattron(status_bar, A_BLINK);
+        mvwprintw(status_bar, 0, pos, "%d", num);
+        wattroff(status_bar, status_attrs);
+        wattroff(status_bar, A_BLINK);
+    } else {
+        int status_attrs = theme_attrs(THEME_STATUS_ACTIVE);
+        wattron(status_bar, status_attrs);
+        mvwprintw(status_bar, 0, pos, "%d", num);
+        wattroff(status_bar, status_attrs);
+    }
+    pos += _activity_item_width(num) - 2;
+
+    wattron(status_bar, bracket_attrs);
+    mvwaddch(status_bar, 0, pos++, is_current ? '-' : ']');
+    wattroff(status_bar, bracket_attrs);
+
+    return pos;
+}
+
+// draw the current window followed by windows with new messages, right aligned,
+// only the indicator region is repainted
+static void
+_activity_draw(void)
+{
+    int cols = getmaxx(stdscr);
+    int max_width = cols / 2;
+    int i;
+
+    for (i = cols - 1 - activity_width; i < cols - 1; i++) {
+        mvwaddch(status_bar, 0, i, ' ');
+    }
+
+    GList *nums = g_hash_table_get_keys(activity);
+    nums = g_list_sort(nums, _activity_cmp);
+
+    int width = _activity_item_width(current_num);
+    int shown = 0;
+    gboolean more = FALSE;
+    GList *curr = nums;
+    while (curr) {
+        int num = GPOINTER_TO_INT(curr->data);
+        if (num != current_num) {
+            int item_width = _activity_item_width(num);
+            if (width + item_width + 3 > max_width) {
+                more = TRUE;
+                break;
+            }
+            width += item_width;
+            shown++;
+        }
+        curr = g_list_next(curr);
+    }
+    if (more) {
+        width += 3;
+    }
+
+    int pos = cols - 1 - width;
+    pos = _activity_print(pos, current_num, TRUE);
+
+    curr = nums;
+    while (curr && shown > 0) {
+        int num = GPOINTER_TO_INT(curr->data);
+        if (num != current_num) {
+            pos = _activity_print(pos, num, FALSE);
+            shown--;
+        }
+        curr = g_list_next(curr);
+    }
+    g_list_free(nums);
+
+    if (more) {
+        int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
+        int status_attrs = theme_attrs(THEME_STATUS_NEW);
+        wattron(status_bar, bracket_attrs);
+        mvwaddch(status_bar, 0, pos, '[');
+        wattroff(status_bar, bracket_attrs);
+        wattron(status_bar, status_attrs);
+        mvwaddch(status_bar, 0, pos + 1, '>');
+        wattroff(status_bar, status_attrs);
+        wattron(status_bar, bracket_attrs);
+        mvwaddch(status_bar, 0, pos + 2, ']');
+        wattroff(status_bar, bracket_attrs);
+    }
+
+    activity_width = width;
+}
+
 static void
 _status_bar_draw(void)
 {
@@ -476,7 +690,6 @@ _status_bar_draw(void)
     }
     prefs_free_string(time_pref);
 
-    _update_win_statuses();
     wnoutrefresh(status_bar);
     inp_put_back();
 }
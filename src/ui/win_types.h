@@ -111,6 +111,7 @@ typedef struct prof_layout_t {
     ProfBuff buffer;
     int y_pos;
     int paged;
+    int pending;
 } ProfLayout;
 
 typedef struct prof_layout_simple_t {
@@ -52,6 +52,7 @@
 #include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window.h"
+#include "ui/window_list.h"
 #include "ui/screen.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/roster_list.h"
@@ -61,9 +62,13 @@
 
 #define CEILING(X) (X-(int)(X) > 0 ? (int)(X+1) : (int)(X))
 
-static void _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *time,
-    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt);
+static void _win_print(ProfWin *window, const char show_char, int pad_indent, gint64 time,
+    int flags, theme_item_t theme_item, const char *const from, const char *const message, gboolean receipt_pending);
 static void _win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pad_indent);
+static void _win_print_entry(ProfWin *window, ProfBuffEntry *e);
+
+static gulong lines_drawn = 0;
+static gulong lines_deferred = 0;
 
 int
 win_roster_cols(void)
@@ -93,6 +98,7 @@ _win_create_simple_layout(void)
     layout->base.buffer = buffer_create();
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.pending = 0;
     scrollok(layout->base.win, TRUE);
 
     return &layout->base;
@@ -110,6 +116,7 @@ _win_create_split_layout(void)
     layout->base.buffer = buffer_create();
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.pending = 0;
     scrollok(layout->base.win, TRUE);
     layout->subwin = NULL;
     layout->sub_y_pos = 0;
@@ -177,6 +184,7 @@ win_create_muc(const char *const roomjid)
     layout->base.buffer = buffer_create();
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.pending = 0;
     scrollok(layout->base.win, TRUE);
     new_win->window.layout = (ProfLayout*)layout;
 
@@ -1029,40 +1037,45 @@ void
 win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *timestamp,
     int flags, theme_item_t theme_item, const char *const from, const char *const message)
 {
-    if (timestamp == NULL) {
-        timestamp = g_date_time_new_now_local();
+    gint64 ts = timestamp ? g_date_time_to_unix(timestamp) : time(NULL);
+
+    buffer_push(window->layout->buffer, show_char, pad_indent, ts, flags, theme_item, from, message, NULL);
+    if (wins_is_current(window)) {
+        _win_print(window, show_char, pad_indent, ts, flags, theme_item, from, message, FALSE);
     } else {
-        g_date_time_ref(timestamp);
+        window->layout->pending++;
+        lines_deferred++;
     }
-
-    buffer_push(window->layout->buffer, show_char, pad_indent, timestamp, flags, theme_item, from, message, NULL);
-    _win_print(window, show_char, pad_indent, timestamp, flags, theme_item, from, message, NULL);
     // TODO: cross-reference.. this should be replaced by a real event-based system
     inp_nonblocking(TRUE);
-    g_date_time_unref(timestamp);
+}
+
+void
+win_print_deferred(ProfWin *window, const char show_char, int pad_indent, GDateTime *timestamp,
+    int flags, theme_item_t theme_item, const char *const from, const char *const message)
+{
+    gint64 ts = timestamp ? g_date_time_to_unix(timestamp) : time(NULL);
+
+    buffer_push(window->layout->buffer, show_char, pad_indent, ts, flags, theme_item, from, message, NULL);
+    window->layout->pending++;
+    lines_deferred++;
 }
 
 void
 win_print_with_receipt(ProfWin *window, const char show_char, int pad_indent, GTimeVal *tstamp,
     int flags, theme_item_t theme_item, const char *const from, const char *const message, char *id)
 {
-    GDateTime *time;
+    gint64 ts = tstamp ? tstamp->tv_sec : time(NULL);
 
-    if (tstamp == NULL) {
-        time = g_date_time_new_now_local();
+    buffer_push(window->layout->buffer, show_char, pad_indent, ts, flags, theme_item, from, message, id);
+    if (wins_is_current(window)) {
+        _win_print(window, show_char, pad_indent, ts, flags, theme_item, from, message, TRUE);
     } else {
-        time = g_date_time_new_from_timeval_utc(tstamp);
+        window->layout->pending++;
+        lines_deferred++;
     }
-
-    DeliveryReceipt *receipt = malloc(sizeof(struct delivery_receipt_t));
-    receipt->id = strdup(id);
-    receipt->received = FALSE;
-
-    buffer_push(window->layout->buffer, show_char, pad_indent, time, flags, theme_item, from, message, receipt);
-    _win_print(window, show_char, pad_indent, time, flags, theme_item, from, message, receipt);
     // TODO: cross-reference.. this should be replaced by a real event-based system
     inp_nonblocking(TRUE);
-    g_date_time_unref(time);
 }
 
 void
@@ -1077,10 +1090,7 @@ win_mark_received(ProfWin *window, const char *const id)
 void
 win_update_entry_message(ProfWin *window, const char *const id, const char *const message)
 {
-    ProfBuffEntry *entry = buffer_yield_entry_by_id(window->layout->buffer, id);
-    if (entry) {
-        free(entry->message);
-        entry->message = strdup(message);
+    if (buffer_update_message(window->layout->buffer, id, message)) {
         win_redraw(window);
     }
 }
@@ -1120,9 +1130,11 @@ win_newline(ProfWin *window)
 }
 
 static void
-_win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *time,
-    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt)
+_win_print(ProfWin *window, const char show_char, int pad_indent, gint64 time,
+    int flags, theme_item_t theme_item, const char *const from, const char *const message, gboolean receipt_pending)
 {
+    lines_drawn++;
+
     // flags : 1st bit =  0/1 - me/not me
     //         2nd bit =  0/1 - date/no date
     //         3rd bit =  0/1 - eol/no eol
@@ -1159,7 +1171,9 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     if (g_strcmp0(time_pref, "off") == 0) {
         date_fmt = g_strdup("");
     } else {
-        date_fmt = g_date_time_format(time, time_pref);
+        GDateTime *datetime = g_date_time_new_from_unix_local(time);
+        date_fmt = g_date_time_format(datetime, time_pref);
+        g_date_time_unref(datetime);
     }
     prefs_free_string(time_pref);
     assert(date_fmt != NULL);
@@ -1190,7 +1204,7 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
             colour = 0;
         }
 
-        if (receipt && !receipt->received) {
+        if (receipt_pending) {
             colour = theme_attrs(THEME_RECEIPT_SENT);
         }
 
@@ -1207,7 +1221,7 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     }
 
     if (!me_message) {
-        if (receipt && !receipt->received) {
+        if (receipt_pending) {
             wbkgdset(window->layout->win, theme_attrs(THEME_RECEIPT_SENT));
             wattron(window->layout->win, theme_attrs(THEME_RECEIPT_SENT));
         } else {
@@ -1232,7 +1246,7 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     if (me_message) {
         wattroff(window->layout->win, colour);
     } else {
-        if (receipt && !receipt->received) {
+        if (receipt_pending) {
             wattroff(window->layout->win, theme_attrs(THEME_RECEIPT_SENT));
         } else {
             wattroff(window->layout->win, theme_attrs(theme_item));
@@ -1242,6 +1256,13 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     g_free(date_fmt);
 }
 
+static void
+_win_print_entry(ProfWin *window, ProfBuffEntry *e)
+{
+    _win_print(window, e->show_char, e->pad_indent, e->time, e->flags, e->theme_item, e->from, e->message,
+        buffer_entry_receipt_pending(e));
+}
+
 static void
 _win_indent(WINDOW *win, int size)
 {
@@ -1277,7 +1298,13 @@ _win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pa
         } else {
             wordi = 0;
             int wordlen = 0;
+            gboolean ascii = TRUE;
             while (*curr_ch != ' ' && *curr_ch != '\n' && *curr_ch != '\0') {
+                if (!(*curr_ch & 0x80)) {
+                    word[wordi++] = *curr_ch++;
+                    continue;
+                }
+                ascii = FALSE;
                 size_t ch_len = mbrlen(curr_ch, MB_CUR_MAX, NULL);
                 if ((ch_len == (size_t)-2) || (ch_len == (size_t)-1)) {
                     curr_ch++;
@@ -1290,7 +1317,7 @@ _win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pa
                 curr_ch = g_utf8_next_char(curr_ch);
             }
             word[wordi] = '\0';
-            wordlen = utf8_display_len(word);
+            wordlen = ascii ? wordi : utf8_display_len(word);
 
             int curx = getcurx(win);
             int cury = getcury(win);
@@ -1371,13 +1398,58 @@ void
 win_redraw(ProfWin *window)
 {
     int i, size;
-    werase(window->layout->win);
     size = buffer_size(window->layout->buffer);
 
+    // not visible, redraw everything when the window is next shown
+    if (!wins_is_current(window)) {
+        window->layout->pending = size;
+        return;
+    }
+
+    werase(window->layout->win);
+    window->layout->pending = 0;
+
     for (i = 0; i < size; i++) {
         ProfBuffEntry *e = buffer_yield_entry(window->layout->buffer, i);
-        _win_print(window, e->show_char, e->pad_indent, e->time, e->flags, e->theme_item, e->from, e->message, e->receipt);
+        _win_print_entry(window, e);
+    }
+}
+
+void
+win_render_pending(ProfWin *window)
+{
+    int pending = window->layout->pending;
+    if (pending == 0) {
+        return;
     }
+
+    int size = buffer_size(window->layout->buffer);
+
+    // older entries were dropped from the buffer, or a full redraw was requested
+    if (pending >= size) {
+        win_redraw(window);
+        return;
+    }
+
+    window->layout->pending = 0;
+
+    int i;
+    for (i = size - pending; i < size; i++) {
+        ProfBuffEntry *e = buffer_yield_entry(window->layout->buffer, i);
+        _win_print_entry(window, e);
+    }
+}
+
+gulong
+win_get_lines_drawn(void)
+{
+    return lines_drawn;
+}
+
+gulong
+win_get_lines_deferred(void)
+{
+    return lines_deferred;
 }
 
 gboolean
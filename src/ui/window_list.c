@@ -341,6 +341,7 @@ wins_set_current_by_num(int i)
     ProfWin *window = g_hash_table_lookup(windows, GINT_TO_POINTER(i));
     if (window) {
         current = i;
+        win_render_pending(window);
         if (window->type == WIN_CHAT) {
             ProfChatWin *chatwin = (ProfChatWin*) window;
             assert(chatwin->memcheck == PROFCHATWIN_MEMCHECK);
@@ -520,7 +521,7 @@ wins_close_by_num(int i)
 
         // go to console if closing current window
         if (i == current) {
-            current = 1;
+            wins_set_current_by_num(1);
             ProfWin *window = wins_get_current();
             win_update_virtual(window);
         }
@@ -532,7 +533,7 @@ wins_close_by_num(int i)
             while (upload_process) {
                 HTTPUpload *upload = upload_process->data;
                 if (upload->window == window) {
-                    upload->cancel = 1;
+                    http_upload_cancel(upload);
                     break;
                 }
                 upload_process = g_slist_next(upload_process);
@@ -1021,7 +1022,7 @@ wins_tidy(void)
 
         g_hash_table_destroy(windows);
         windows = new_windows;
-        current = 1;
+        wins_set_current_by_num(1);
         ProfWin *console = wins_get_console();
         ui_focus_win(console);
         g_list_free(keys);
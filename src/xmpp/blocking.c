@@ -56,6 +56,7 @@
 static int _blocklist_result_handler(xmpp_stanza_t *const stanza, void *const userdata);
 static int _block_add_result_handler(xmpp_stanza_t *const stanza, void *const userdata);
 static int _block_remove_result_handler(xmpp_stanza_t *const stanza, void *const userdata);
+static void _blocked_set_handler(xmpp_stanza_t *stanza);
 
 static GList *blocked;
 static Autocomplete blocked_ac;
@@ -73,6 +74,9 @@ blocking_request(void)
     }
     blocked_ac = autocomplete_new();
 
+    // pushes update the list created above, so only listen for them from now on
+    iq_ns_handler_add(STANZA_NS_BLOCKING, STANZA_TYPE_SET, _blocked_set_handler);
+
     char *id = create_unique_id("blocked_list_request");
     iq_id_handler_add(id, _blocklist_result_handler, NULL, NULL);
 
@@ -177,8 +181,8 @@ blocked_remove(char *jid)
     return TRUE;
 }
 
-int
-blocked_set_handler(xmpp_stanza_t *stanza)
+static void
+_blocked_set_handler(xmpp_stanza_t *stanza)
 {
     xmpp_stanza_t *block = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_BLOCK);
     if (block) {
@@ -223,8 +227,6 @@ blocked_set_handler(xmpp_stanza_t *stanza)
             }
         }
     }
-
-    return 1;
 }
 
 static int
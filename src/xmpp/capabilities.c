@@ -58,13 +58,21 @@
 #include "plugins/plugins.h"
 #include "config/files.h"
 #include "config/preferences.h"
+#include "config/persist.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/stanza.h"
 #include "xmpp/form.h"
 #include "xmpp/capabilities.h"
 
+// seconds to batch newly learned capabilities before writing the cache file
+#define CAPS_SAVE_INTERVAL 10
+
 static char *cache_loc;
 static GKeyFile *cache;
+static PersistStore *cache_store;
+
+// ver to parsed capabilities, filled from the cache file on first use
+static GHashTable *ver_to_caps;
 
 static GHashTable *jid_to_ver;
 static GHashTable *jid_to_caps;
@@ -72,10 +80,24 @@ static GHashTable *jid_to_caps;
 static GHashTable *prof_features;
 static char *my_sha1;
 
+// seconds after which an unanswered capabilities query is sent again
+#define CAPS_PENDING_TIMEOUT 60
+
+typedef struct caps_pending_t {
+    char *node;
+    char *ver;
+    char *queried;
+    GSList *jids;
+    gint64 started;
+} CapsPending;
+
+// ver or node#ver to queries awaiting a response
+static GHashTable *pending;
+
 static void _save_cache(void);
 static EntityCapabilities* _caps_by_ver(const char *const ver);
 static EntityCapabilities* _caps_by_jid(const char *const jid);
-static EntityCapabilities* _caps_copy(EntityCapabilities *caps);
+static void _caps_pending_free(CapsPending *caps_pending);
 
 void
 caps_init(void)
@@ -89,9 +111,12 @@ caps_init(void)
 
     cache = g_key_file_new();
     g_key_file_load_from_file(cache, cache_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    cache_store = persist_store_new(cache, cache_loc, CAPS_SAVE_INTERVAL);
 
+    ver_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)caps_destroy);
     jid_to_ver = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
     jid_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)caps_destroy);
+    pending = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_caps_pending_free);
 
     prof_features = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
     g_hash_table_add(prof_features, strdup(STANZA_NS_CAPS));
@@ -179,6 +204,7 @@ caps_create(const char *const category, const char *const type, const char *cons
     GSList *features)
 {
     EntityCapabilities *result = (EntityCapabilities *)malloc(sizeof(EntityCapabilities));
+    result->refcount = 1;
 
     if (category || type || name) {
         DiscoIdentity *identity = (DiscoIdentity*)malloc(sizeof(DiscoIdentity));
@@ -218,11 +244,12 @@ caps_add_by_ver(const char *const ver, EntityCapabilities *caps)
         return;
     }
 
-    gboolean cached = g_key_file_has_group(cache, ver);
-    if (cached) {
+    if (caps_cache_contains(ver)) {
         return;
     }
 
+    g_hash_table_insert(ver_to_caps, strdup(ver), caps_ref(caps));
+
     if (caps->identity) {
         DiscoIdentity *identity = caps->identity;
         if (identity->name) {
@@ -282,7 +309,98 @@ caps_map_jid_to_ver(const char *const jid, const char *const ver)
 gboolean
 caps_cache_contains(const char *const ver)
 {
-    return (g_key_file_has_group(cache, ver));
+    return g_hash_table_contains(ver_to_caps, ver) || g_key_file_has_group(cache, ver);
+}
+
+gboolean
+caps_pending_add(const char *const key, const char *const jid, const char *const node, const char *const ver)
+{
+    gint64 now = g_get_monotonic_time();
+    CapsPending *caps_pending = g_hash_table_lookup(pending, key);
+
+    if (caps_pending && (now - caps_pending->started) < (gint64)CAPS_PENDING_TIMEOUT * G_USEC_PER_SEC) {
+        if (!g_slist_find_custom(caps_pending->jids, jid, (GCompareFunc)g_strcmp0)) {
+            caps_pending->jids = g_slist_prepend(caps_pending->jids, strdup(jid));
+        }
+        return TRUE;
+    }
+
+    // no query in flight, or the previous one was never answered
+    if (caps_pending == NULL) {
+        caps_pending = malloc(sizeof(CapsPending));
+        caps_pending->node = node ? strdup(node) : NULL;
+        caps_pending->ver = ver ? strdup(ver) : NULL;
+        caps_pending->queried = NULL;
+        caps_pending->jids = NULL;
+        g_hash_table_insert(pending, strdup(key), caps_pending);
+    }
+    caps_pending->started = now;
+    free(caps_pending->queried);
+    caps_pending->queried = strdup(jid);
+    if (!g_slist_find_custom(caps_pending->jids, jid, (GCompareFunc)g_strcmp0)) {
+        caps_pending->jids = g_slist_prepend(caps_pending->jids, strdup(jid));
+    }
+
+    return FALSE;
+}
+
+void
+caps_pending_resolve(const char *const key)
+{
+    CapsPending *caps_pending = g_hash_table_lookup(pending, key);
+    if (caps_pending == NULL) {
+        return;
+    }
+
+    log_debug("Capabilities query for %s answered, %d waiting", key, g_slist_length(caps_pending->jids));
+    GSList *curr = caps_pending->jids;
+    while (curr) {
+        caps_map_jid_to_ver(curr->data, key);
+        curr = g_slist_next(curr);
+    }
+
+    g_hash_table_remove(pending, key);
+}
+
+// the queried jid gave no usable answer and stops waiting, returns the next one to query
+gboolean
+caps_pending_next(const char *const key, char **jid, char **node, char **ver)
+{
+    CapsPending *caps_pending = g_hash_table_lookup(pending, key);
+    if (caps_pending == NULL) {
+        return FALSE;
+    }
+
+    if (caps_pending->queried) {
+        GSList *found = g_slist_find_custom(caps_pending->jids, caps_pending->queried, (GCompareFunc)g_strcmp0);
+        if (found) {
+            free(found->data);
+            caps_pending->jids = g_slist_delete_link(caps_pending->jids, found);
+        }
+        FREE_SET_NULL(caps_pending->queried);
+    }
+
+    if (caps_pending->jids == NULL) {
+        g_hash_table_remove(pending, key);
+        return FALSE;
+    }
+
+    caps_pending->queried = strdup(caps_pending->jids->data);
+    caps_pending->started = g_get_monotonic_time();
+
+    *jid = strdup(caps_pending->queried);
+    *node = caps_pending->node ? strdup(caps_pending->node) : NULL;
+    *ver = caps_pending->ver ? strdup(caps_pending->ver) : NULL;
+
+    return TRUE;
+}
+
+void
+caps_pending_clear(void)
+{
+    if (pending) {
+        g_hash_table_remove_all(pending);
+    }
 }
 
 EntityCapabilities*
@@ -293,13 +411,13 @@ caps_lookup(const char *const jid)
         EntityCapabilities *caps = _caps_by_ver(ver);
         if (caps) {
             log_debug("Capabilities lookup %s, found by verification string %s.", jid, ver);
-            return caps;
+            return caps_ref(caps);
         }
     } else {
         EntityCapabilities *caps = _caps_by_jid(jid);
         if (caps) {
             log_debug("Capabilities lookup %s, found by JID.", jid);
-            return _caps_copy(caps);
+            return caps_ref(caps);
         }
     }
 
@@ -310,18 +428,21 @@ caps_lookup(const char *const jid)
 gboolean
 caps_jid_has_feature(const char *const jid, const char *const feature)
 {
-    EntityCapabilities *caps = caps_lookup(jid);
+    EntityCapabilities *caps = NULL;
+    char *ver = g_hash_table_lookup(jid_to_ver, jid);
+    if (ver) {
+        caps = _caps_by_ver(ver);
+    } else {
+        caps = _caps_by_jid(jid);
+    }
 
     if (caps == NULL) {
         return FALSE;
     }
 
     GSList *found = g_slist_find_custom(caps->features, feature, (GCompareFunc)g_strcmp0);
-    gboolean result = found != NULL;
-
-    caps_destroy(caps);
 
-    return result;
+    return found != NULL;
 }
 
 char*
@@ -348,10 +469,17 @@ caps_reset_ver(void)
 void
 caps_close(void)
 {
+    persist_store_free(cache_store);
+    cache_store = NULL;
+
+    g_hash_table_destroy(ver_to_caps);
+    ver_to_caps = NULL;
     g_key_file_free(cache);
     cache = NULL;
     g_hash_table_destroy(jid_to_ver);
     g_hash_table_destroy(jid_to_caps);
+    g_hash_table_destroy(pending);
+    pending = NULL;
     free(cache_loc);
     cache_loc = NULL;
     g_hash_table_destroy(prof_features);
@@ -361,6 +489,11 @@ caps_close(void)
 static EntityCapabilities*
 _caps_by_ver(const char *const ver)
 {
+    EntityCapabilities *caps = g_hash_table_lookup(ver_to_caps, ver);
+    if (caps) {
+        return caps;
+    }
+
     if (!g_key_file_has_group(cache, ver)) {
         return NULL;
     }
@@ -401,6 +534,8 @@ _caps_by_ver(const char *const ver)
     }
     g_slist_free(features);
 
+    g_hash_table_insert(ver_to_caps, strdup(ver), result);
+
     return result;
 }
 
@@ -410,25 +545,6 @@ _caps_by_jid(const char *const jid)
     return g_hash_table_lookup(jid_to_caps, jid);
 }
 
-static EntityCapabilities*
-_caps_copy(EntityCapabilities *caps)
-{
-    if (!caps) {
-        return NULL;
-    }
-
-    const char *const categoty = caps->identity ? caps->identity->category : NULL;
-    const char *const type = caps->identity ? caps->identity->type : NULL;
-    const char *const name = caps->identity ? caps->identity->name : NULL;
-
-    const char *const software = caps->software_version ? caps->software_version->software : NULL;
-    const char *const software_version = caps->software_version ? caps->software_version->software_version : NULL;
-    const char *const os = caps->software_version ? caps->software_version->os : NULL;
-    const char *const os_version = caps->software_version ? caps->software_version->os_version : NULL;
-
-    return caps_create(categoty, type, name, software, software_version, os, os_version, caps->features);
-}
-
 static void
 _disco_identity_destroy(DiscoIdentity *disco_identity)
 {
@@ -452,10 +568,32 @@ _software_version_destroy(SoftwareVersion *software_version)
     }
 }
 
+static void
+_caps_pending_free(CapsPending *caps_pending)
+{
+    if (caps_pending) {
+        free(caps_pending->node);
+        free(caps_pending->ver);
+        free(caps_pending->queried);
+        g_slist_free_full(caps_pending->jids, free);
+        free(caps_pending);
+    }
+}
+
+EntityCapabilities*
+caps_ref(EntityCapabilities *caps)
+{
+    if (caps) {
+        caps->refcount++;
+    }
+
+    return caps;
+}
+
 void
 caps_destroy(EntityCapabilities *caps)
 {
-    if (caps) {
+    if (caps && --caps->refcount == 0) {
         _disco_identity_destroy(caps->identity);
         _software_version_destroy(caps->software_version);
         if (caps->features) {
@@ -468,9 +606,5 @@ caps_destroy(EntityCapabilities *caps)
 static void
 _save_cache(void)
 {
-    gsize g_data_size;
-    gchar *g_cache_data = g_key_file_to_data(cache, &g_data_size, NULL);
-    g_file_set_contents(cache_loc, g_cache_data, g_data_size, NULL);
-    g_chmod(cache_loc, S_IRUSR | S_IWUSR);
-    g_free(g_cache_data);
+    persist_store_mark_dirty(cache_store);
 }
@@ -57,6 +57,10 @@ void caps_add_by_ver(const char *const ver, EntityCapabilities *caps);
 void caps_add_by_jid(const char *const jid, EntityCapabilities *caps);
 void caps_map_jid_to_ver(const char *const jid, const char *const ver);
 gboolean caps_cache_contains(const char *const ver);
+gboolean caps_pending_add(const char *const key, const char *const jid, const char *const node, const char *const ver);
+void caps_pending_resolve(const char *const key);
+gboolean caps_pending_next(const char *const key, char **jid, char **node, char **ver);
+void caps_pending_clear(void);
 GList* caps_get_features(void);
 char* caps_get_my_sha1(xmpp_ctx_t *const ctx);
 
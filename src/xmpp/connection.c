@@ -49,10 +49,16 @@
 #include "log.h"
 #include "config/preferences.h"
 #include "event/server_events.h"
+#include "xmpp/capabilities.h"
 #include "xmpp/connection.h"
 #include "xmpp/session.h"
+#include "xmpp/stanza.h"
 #include "xmpp/iq.h"
 
+// stanza text buffers grown beyond this are released rather than kept for reuse
+#define STANZA_TEXT_MAX_RETAIN (64 * 1024)
+#define STANZA_ARENA_BLOCK_SIZE 4096
+
 typedef struct prof_conn_t {
     xmpp_log_t *xmpp_log;
     xmpp_ctx_t *xmpp_ctx;
@@ -63,6 +69,12 @@ typedef struct prof_conn_t {
     char *domain;
     GHashTable *available_resources;
     GHashTable *features_by_jid;
+    GString *stanza_text;
+    unsigned long stanza_text_skipped;
+    Arena stanza_arena;
+#ifdef HAVE_XMPP_CONN_GET_SM_STATE
+    xmpp_sm_state_t *sm_state;
+#endif
 } ProfConnection;
 
 static ProfConnection conn;
@@ -89,6 +101,12 @@ connection_init(void)
     conn.domain = NULL;
     conn.features_by_jid = NULL;
     conn.available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)resource_destroy);
+    conn.stanza_text = NULL;
+    conn.stanza_text_skipped = 0;
+    conn.stanza_arena = arena_new(STANZA_ARENA_BLOCK_SIZE);
+#ifdef HAVE_XMPP_CONN_GET_SM_STATE
+    conn.sm_state = NULL;
+#endif
 }
 
 void
@@ -101,8 +119,17 @@ void
 connection_shutdown(void)
 {
     connection_clear_data();
+    connection_sm_reset();
     xmpp_shutdown();
 
+    if (conn.stanza_text) {
+        g_string_free(conn.stanza_text, TRUE);
+        conn.stanza_text = NULL;
+    }
+
+    arena_free(conn.stanza_arena);
+    conn.stanza_arena = NULL;
+
     free(conn.xmpp_log);
     conn.xmpp_log = NULL;
 }
@@ -153,6 +180,18 @@ connection_connect(const char *const fulljid, const char *const passwd, const ch
     xmpp_conn_set_jid(conn.xmpp_conn, fulljid);
     xmpp_conn_set_pass(conn.xmpp_conn, passwd);
 
+#ifdef HAVE_XMPP_CONN_GET_SM_STATE
+    // the library sends <resume/> and falls back to a new session if the server refuses
+    if (conn.sm_state) {
+        if (xmpp_conn_set_sm_state(conn.xmpp_conn, conn.sm_state) == XMPP_EOK) {
+            conn.sm_state = NULL;
+        } else {
+            log_warning("Failed to restore stream management state, starting a new session");
+            connection_sm_reset();
+        }
+    }
+#endif
+
     if (!tls_policy || (g_strcmp0(tls_policy, "force") == 0)) {
         xmpp_conn_set_flags(conn.xmpp_conn, XMPP_CONN_FLAG_MANDATORY_TLS);
     } else if (g_strcmp0(tls_policy, "disable") == 0) {
@@ -194,6 +233,10 @@ connection_connect(const char *const fulljid, const char *const passwd, const ch
 void
 connection_disconnect(void)
 {
+    log_debug("Stanza serialisations avoided: %lu", conn.stanza_text_skipped);
+    log_debug("Stanza arena: %lu allocations in %lu blocks over %lu stanzas",
+        arena_get_allocs(conn.stanza_arena), arena_get_blocks(conn.stanza_arena), arena_get_resets(conn.stanza_arena));
+
     conn.conn_status = JABBER_DISCONNECTING;
     xmpp_disconnect(conn.xmpp_conn);
 
@@ -231,6 +274,9 @@ connection_clear_data(void)
     if (conn.available_resources) {
         g_hash_table_remove_all(conn.available_resources);
     }
+
+    // the id handlers that would answer them go with the connection
+    caps_pending_clear();
 }
 
 #ifdef HAVE_LIBMESODE
@@ -266,6 +312,17 @@ connection_send_stanza(const char *const stanza)
     }
 }
 
+void
+connection_sm_reset(void)
+{
+#ifdef HAVE_XMPP_CONN_GET_SM_STATE
+    if (conn.sm_state) {
+        xmpp_free_sm_state(conn.sm_state);
+        conn.sm_state = NULL;
+    }
+#endif
+}
+
 gboolean
 connection_supports(const char *const feature)
 {
@@ -330,6 +387,49 @@ connection_get_status(void)
     return conn.conn_status;
 }
 
+const char*
+connection_stanza_text(xmpp_stanza_t *const stanza)
+{
+    if (conn.stanza_text && conn.stanza_text->allocated_len > STANZA_TEXT_MAX_RETAIN) {
+        g_string_free(conn.stanza_text, TRUE);
+        conn.stanza_text = NULL;
+    }
+
+    if (conn.stanza_text == NULL) {
+        conn.stanza_text = g_string_sized_new(1024);
+    } else {
+        g_string_truncate(conn.stanza_text, 0);
+    }
+
+    stanza_append_text(stanza, conn.stanza_text);
+
+    return conn.stanza_text->str;
+}
+
+void
+connection_stanza_text_skipped(void)
+{
+    conn.stanza_text_skipped++;
+}
+
+unsigned long
+connection_get_stanza_text_skipped(void)
+{
+    return conn.stanza_text_skipped;
+}
+
+Arena
+connection_stanza_arena(void)
+{
+    return conn.stanza_arena;
+}
+
+void
+connection_stanza_done(void)
+{
+    arena_reset(conn.stanza_arena);
+}
+
 xmpp_conn_t*
 connection_get_conn(void)
 {
@@ -442,6 +542,11 @@ _connection_handler(xmpp_conn_t *const xmpp_conn, const xmpp_conn_event_t status
         // lost connection for unknown reason
         if (conn.conn_status == JABBER_CONNECTED) {
             log_debug("Connection handler: Lost connection for unknown reason");
+#ifdef HAVE_XMPP_CONN_GET_SM_STATE
+            // kept for the automatic reconnect, with the stanzas the server has not acknowledged
+            connection_sm_reset();
+            conn.sm_state = xmpp_conn_get_sm_state(conn.xmpp_conn);
+#endif
             session_lost_connection();
 
         // login attempt failed
@@ -45,6 +45,7 @@ jabber_conn_status_t connection_connect(const char *const fulljid, const char *c
     const char *const tls_policy);
 void connection_disconnect(void);
 void connection_set_disconnected(void);
+void connection_sm_reset(void);
 
 void connection_set_presence_msg(const char *const message);
 void connection_set_priority(const int priority);
@@ -59,6 +60,10 @@ GHashTable* connection_get_features(const char *const jid);
 
 void connection_clear_data(void);
 
+const char* connection_stanza_text(xmpp_stanza_t *const stanza);
+void connection_stanza_text_skipped(void);
+void connection_stanza_done(void);
+
 void connection_add_available_resource(Resource *resource);
 void connection_remove_available_resource(const char *const resource);
 
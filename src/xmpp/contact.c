@@ -40,6 +40,7 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
 #include "xmpp/resource.h"
 #include "xmpp/contact.h"
 
@@ -57,6 +58,21 @@ struct p_contact_t {
     Autocomplete resource_ac;
 };
 
+// group names repeat across most contacts, keep one copy of each
+static GSList*
+_intern_groups(GSList *groups)
+{
+    GSList *curr = groups;
+    while (curr) {
+        char *group = curr->data;
+        curr->data = intern_ref(group);
+        g_free(group);
+        curr = g_slist_next(curr);
+    }
+
+    return groups;
+}
+
 PContact
 p_contact_new(const char *const barejid, const char *const name,
     GSList *groups, const char *const subscription,
@@ -74,7 +90,7 @@ p_contact_new(const char *const barejid, const char *const name,
         contact->name_collate_key = NULL;
     }
 
-    contact->groups = groups;
+    contact->groups = _intern_groups(groups);
 
     if (subscription)
         contact->subscription = strdup(subscription);
@@ -112,11 +128,11 @@ void
 p_contact_set_groups(const PContact contact, GSList *groups)
 {
     if (contact->groups) {
-        g_slist_free_full(contact->groups, g_free);
+        g_slist_free_full(contact->groups, (GDestroyNotify)intern_unref);
         contact->groups = NULL;
     }
 
-    contact->groups = groups;
+    contact->groups = _intern_groups(groups);
 }
 
 gboolean
@@ -160,7 +176,7 @@ p_contact_free(PContact contact)
         free(contact->offline_message);
 
         if (contact->groups) {
-            g_slist_free_full(contact->groups, g_free);
+            g_slist_free_full(contact->groups, (GDestroyNotify)intern_unref);
         }
 
         if (contact->last_activity) {
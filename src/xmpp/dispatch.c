@@ -0,0 +1,199 @@
+/*
+ * dispatch.c
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_LIBMESODE
+#include <mesode.h>
+#endif
+
+#ifdef HAVE_LIBSTROPHE
+#include <strophe.h>
+#endif
+
+#include <glib.h>
+
+#include "xmpp/dispatch.h"
+
+typedef struct dispatch_entry_t {
+    char *type;
+    ProfNsCallback func;
+} DispatchEntry;
+
+struct prof_dispatch_t {
+    // namespace to list of DispatchEntry, in registration order
+    GHashTable *by_ns;
+};
+
+static void
+_dispatch_entry_free(DispatchEntry *entry)
+{
+    if (entry) {
+        free(entry->type);
+        free(entry);
+    }
+}
+
+static void
+_dispatch_entries_free(GList *entries)
+{
+    g_list_free_full(entries, (GDestroyNotify)_dispatch_entry_free);
+}
+
+// handlers run once per namespace, so skip children whose namespace an
+// earlier sibling already had, stanzas only have a handful of children
+static gboolean
+_dispatch_ns_seen(xmpp_stanza_t *first, xmpp_stanza_t *child, const char *const ns)
+{
+    xmpp_stanza_t *curr = first;
+    while (curr != child) {
+        if (g_strcmp0(xmpp_stanza_get_ns(curr), ns) == 0) {
+            return TRUE;
+        }
+        curr = xmpp_stanza_get_next(curr);
+    }
+
+    return FALSE;
+}
+
+ProfDispatch*
+dispatch_new(void)
+{
+    ProfDispatch *dispatch = malloc(sizeof(ProfDispatch));
+    dispatch->by_ns = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_dispatch_entries_free);
+
+    return dispatch;
+}
+
+void
+dispatch_free(ProfDispatch *dispatch)
+{
+    if (dispatch) {
+        g_hash_table_destroy(dispatch->by_ns);
+        free(dispatch);
+    }
+}
+
+void
+dispatch_add(ProfDispatch *dispatch, const char *const ns, const char *const type, ProfNsCallback func)
+{
+    if (dispatch == NULL || ns == NULL || func == NULL) {
+        return;
+    }
+
+    GList *entries = g_hash_table_lookup(dispatch->by_ns, ns);
+    GList *curr = entries;
+    while (curr) {
+        // registering again on reconnect must not run the handler twice
+        DispatchEntry *entry = curr->data;
+        if (entry->func == func && g_strcmp0(entry->type, type) == 0) {
+            return;
+        }
+        curr = g_list_next(curr);
+    }
+
+    DispatchEntry *entry = malloc(sizeof(DispatchEntry));
+    entry->type = type ? strdup(type) : NULL;
+    entry->func = func;
+
+    if (entries) {
+        // appending keeps the head, so the table value remains valid
+        entries = g_list_append(entries, entry);
+    } else {
+        g_hash_table_insert(dispatch->by_ns, strdup(ns), g_list_append(NULL, entry));
+    }
+}
+
+void
+dispatch_remove(ProfDispatch *dispatch, const char *const ns, const char *const type, ProfNsCallback func)
+{
+    if (dispatch == NULL || ns == NULL) {
+        return;
+    }
+
+    gpointer key = NULL;
+    gpointer value = NULL;
+    if (!g_hash_table_lookup_extended(dispatch->by_ns, ns, &key, &value)) {
+        return;
+    }
+    g_hash_table_steal(dispatch->by_ns, ns);
+
+    GList *entries = value;
+    GList *curr = entries;
+    while (curr) {
+        GList *next = g_list_next(curr);
+        DispatchEntry *entry = curr->data;
+        if (entry->func == func && g_strcmp0(entry->type, type) == 0) {
+            _dispatch_entry_free(entry);
+            entries = g_list_delete_link(entries, curr);
+        }
+        curr = next;
+    }
+
+    if (entries) {
+        g_hash_table_insert(dispatch->by_ns, key, entries);
+    } else {
+        free(key);
+    }
+}
+
+void
+dispatch_stanza(ProfDispatch *dispatch, xmpp_stanza_t *const stanza, const char *const type)
+{
+    if (dispatch == NULL || g_hash_table_size(dispatch->by_ns) == 0) {
+        return;
+    }
+
+    xmpp_stanza_t *first = xmpp_stanza_get_children(stanza);
+    xmpp_stanza_t *child = first;
+    while (child) {
+        const char *ns = xmpp_stanza_get_ns(child);
+        if (ns && !_dispatch_ns_seen(first, child, ns)) {
+            GList *curr = g_hash_table_lookup(dispatch->by_ns, ns);
+            while (curr) {
+                // handlers may remove themselves
+                GList *next = g_list_next(curr);
+                DispatchEntry *entry = curr->data;
+                if (entry->type == NULL || g_strcmp0(entry->type, type) == 0) {
+                    entry->func(stanza);
+                }
+                curr = next;
+            }
+        }
+        child = xmpp_stanza_get_next(child);
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * dispatch.h
+ *
+ * Copyright (C) 2012 - 2016 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef XMPP_DISPATCH_H
+#define XMPP_DISPATCH_H
+
+#include "xmpp/xmpp.h"
+
+typedef void(*ProfNsCallback)(xmpp_stanza_t *const stanza);
+
+typedef struct prof_dispatch_t ProfDispatch;
+
+ProfDispatch* dispatch_new(void);
+void dispatch_free(ProfDispatch *dispatch);
+
+void dispatch_add(ProfDispatch *dispatch, const char *const ns, const char *const type, ProfNsCallback func);
+void dispatch_remove(ProfDispatch *dispatch, const char *const ns, const char *const type, ProfNsCallback func);
+void dispatch_stanza(ProfDispatch *dispatch, xmpp_stanza_t *const stanza, const char *const type);
+
+#endif
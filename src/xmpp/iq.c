@@ -61,6 +61,7 @@
 #include "ui/window_list.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/connection.h"
+#include "xmpp/dispatch.h"
 #include "xmpp/session.h"
 #include "xmpp/iq.h"
 #include "xmpp/capabilities.h"
@@ -129,19 +130,38 @@ static int _autoping_timed_send(xmpp_conn_t *const conn, void *const userdata);
 static gboolean autoping_wait = FALSE;
 static GTimer *autoping_time = NULL;
 static GHashTable *id_handlers;
+static ProfDispatch *ns_handlers;
+
+static void
+_ns_handlers_init(void)
+{
+    if (ns_handlers) {
+        return;
+    }
+
+    ns_handlers = dispatch_new();
+    dispatch_add(ns_handlers, XMPP_NS_DISCO_INFO, STANZA_TYPE_GET, _disco_info_get_handler);
+    dispatch_add(ns_handlers, XMPP_NS_DISCO_ITEMS, STANZA_TYPE_GET, _disco_items_get_handler);
+    dispatch_add(ns_handlers, XMPP_NS_DISCO_ITEMS, STANZA_TYPE_RESULT, _disco_items_result_handler);
+    dispatch_add(ns_handlers, STANZA_NS_LASTACTIVITY, STANZA_TYPE_GET, _last_activity_get_handler);
+    dispatch_add(ns_handlers, STANZA_NS_VERSION, STANZA_TYPE_GET, _version_get_handler);
+    dispatch_add(ns_handlers, STANZA_NS_PING, STANZA_TYPE_GET, _ping_get_handler);
+    dispatch_add(ns_handlers, XMPP_NS_ROSTER, STANZA_TYPE_SET, roster_set_handler);
+    dispatch_add(ns_handlers, XMPP_NS_ROSTER, STANZA_TYPE_RESULT, roster_result_handler);
+}
 
 static int
 _iq_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *const userdata)
 {
     log_debug("iq stanza handler fired");
 
-    char *text;
-    size_t text_size;
-    xmpp_stanza_to_text(stanza, &text, &text_size);
-    gboolean cont = plugins_on_iq_stanza_receive(text);
-    xmpp_free(connection_get_ctx(), text);
-    if (!cont) {
-        return 1;
+    if (plugins_has_hook(HOOK_ON_IQ_STANZA_RECEIVE)) {
+        gboolean cont = plugins_on_iq_stanza_receive(connection_stanza_text(stanza));
+        if (!cont) {
+            return 1;
+        }
+    } else {
+        connection_stanza_text_skipped();
     }
 
     const char *type = xmpp_stanza_get_type(stanza);
@@ -150,46 +170,7 @@ _iq_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *const us
         _error_handler(stanza);
     }
 
-    xmpp_stanza_t *discoinfo = xmpp_stanza_get_child_by_ns(stanza, XMPP_NS_DISCO_INFO);
-    if (discoinfo && (g_strcmp0(type, STANZA_TYPE_GET) == 0)) {
-        _disco_info_get_handler(stanza);
-    }
-
-    xmpp_stanza_t *discoitems = xmpp_stanza_get_child_by_ns(stanza, XMPP_NS_DISCO_ITEMS);
-    if (discoitems && (g_strcmp0(type, STANZA_TYPE_GET) == 0)) {
-        _disco_items_get_handler(stanza);
-    }
-    if (discoitems && (g_strcmp0(type, STANZA_TYPE_RESULT) == 0)) {
-        _disco_items_result_handler(stanza);
-    }
-
-    xmpp_stanza_t *lastactivity = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_LASTACTIVITY);
-    if (lastactivity && (g_strcmp0(type, STANZA_TYPE_GET) == 0)) {
-        _last_activity_get_handler(stanza);
-    }
-
-    xmpp_stanza_t *version = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_VERSION);
-    if (version && (g_strcmp0(type, STANZA_TYPE_GET) == 0)) {
-        _version_get_handler(stanza);
-    }
-
-    xmpp_stanza_t *ping = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_PING);
-    if (ping && (g_strcmp0(type, STANZA_TYPE_GET) == 0)) {
-        _ping_get_handler(stanza);
-    }
-
-    xmpp_stanza_t *roster = xmpp_stanza_get_child_by_ns(stanza, XMPP_NS_ROSTER);
-    if (roster && (g_strcmp0(type, STANZA_TYPE_SET) == 0)) {
-        roster_set_handler(stanza);
-    }
-    if (roster && (g_strcmp0(type, STANZA_TYPE_RESULT) == 0)) {
-        roster_result_handler(stanza);
-    }
-
-    xmpp_stanza_t *blocking = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_BLOCKING);
-    if (blocking && (g_strcmp0(type, STANZA_TYPE_SET) == 0)) {
-        blocked_set_handler(stanza);
-    }
+    dispatch_stanza(ns_handlers, stanza, type);
 
     const char *id = xmpp_stanza_get_id(stanza);
     if (id) {
@@ -232,6 +213,28 @@ iq_handlers_init(void)
         g_hash_table_destroy(id_handlers);
     }
     id_handlers = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+
+    _ns_handlers_init();
+}
+
+void
+iq_ns_handler_add(const char *const ns, const char *const type, ProfNsCallback func)
+{
+    _ns_handlers_init();
+    dispatch_add(ns_handlers, ns, type, func);
+}
+
+void
+iq_ns_handler_remove(const char *const ns, const char *const type, ProfNsCallback func)
+{
+    dispatch_remove(ns_handlers, ns, type, func);
+}
+
+void
+iq_handlers_clear(void)
+{
+    dispatch_free(ns_handlers);
+    ns_handlers = NULL;
 }
 
 void
@@ -459,7 +462,7 @@ iq_send_caps_request(const char *const to, const char *const id,
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
     g_string_free(node_str, TRUE);
 
-    iq_id_handler_add(id, _caps_response_id_handler, NULL, NULL);
+    iq_id_handler_add(id, _caps_response_id_handler, free, strdup(ver));
 
     iq_send_stanza(iq);
     xmpp_stanza_release(iq);
@@ -687,12 +690,38 @@ _error_handler(xmpp_stanza_t *const stanza)
     free(error_msg);
 }
 
+// the queried entity gave no usable answer, ask the next one waiting on the same ver
+static void
+_caps_request_next(const char *const key, gboolean legacy)
+{
+    char *jid = NULL;
+    char *node = NULL;
+    char *ver = NULL;
+    if (!caps_pending_next(key, &jid, &node, &ver)) {
+        return;
+    }
+
+    log_info("Capabilities query for %s failed, asking %s", key, jid);
+    char *id = create_unique_id("caps");
+    if (legacy) {
+        iq_send_caps_request_legacy(jid, id, node, ver);
+    } else {
+        iq_send_caps_request(jid, id, node, ver);
+    }
+    free(id);
+    free(jid);
+    free(node);
+    free(ver);
+}
+
 static int
 _caps_response_id_handler(xmpp_stanza_t *const stanza, void *const userdata)
 {
     const char *id = xmpp_stanza_get_id(stanza);
     xmpp_stanza_t *query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
 
+    char *expected_ver = (char *)userdata;
+
     const char *type = xmpp_stanza_get_type(stanza);
     // ignore non result
     if ((g_strcmp0(type, "get") == 0) || (g_strcmp0(type, "set") == 0)) {
@@ -708,6 +737,8 @@ _caps_response_id_handler(xmpp_stanza_t *const stanza, void *const userdata)
     const char *from = xmpp_stanza_get_from(stanza);
     if (!from) {
         log_info("No from attribute");
+        _caps_request_next(expected_ver, FALSE);
+        free(expected_ver);
         return 0;
     }
 
@@ -716,17 +747,23 @@ _caps_response_id_handler(xmpp_stanza_t *const stanza, void *const userdata)
         char *error_message = stanza_get_error_message(stanza);
         log_warning("Error received for capabilities response from %s: ", from, error_message);
         free(error_message);
+        _caps_request_next(expected_ver, FALSE);
+        free(expected_ver);
         return 0;
     }
 
     if (query == NULL) {
         log_info("No query element found.");
+        _caps_request_next(expected_ver, FALSE);
+        free(expected_ver);
         return 0;
     }
 
     const char *node = xmpp_stanza_get_attribute(query, STANZA_ATTR_NODE);
     if (node == NULL) {
         log_info("No node attribute found");
+        _caps_request_next(expected_ver, FALSE);
+        free(expected_ver);
         return 0;
     }
 
@@ -739,6 +776,7 @@ _caps_response_id_handler(xmpp_stanza_t *const stanza, void *const userdata)
         log_warning("Generated sha-1 does not match given:");
         log_warning("Generated : %s", generated_sha1);
         log_warning("Given     : %s", given_sha1);
+        _caps_request_next(expected_ver, FALSE);
     } else {
         log_info("Valid SHA-1 hash found: %s", given_sha1);
 
@@ -752,10 +790,17 @@ _caps_response_id_handler(xmpp_stanza_t *const stanza, void *const userdata)
         }
 
         caps_map_jid_to_ver(from, given_sha1);
+        caps_pending_resolve(given_sha1);
+
+        // the queried entity answered for another ver, the waiters still need theirs
+        if (g_strcmp0(expected_ver, given_sha1) != 0) {
+            _caps_request_next(expected_ver, FALSE);
+        }
     }
 
     g_free(generated_sha1);
     g_strfreev(split);
+    free(expected_ver);
 
     return 0;
 }
@@ -841,6 +886,7 @@ _caps_response_legacy_id_handler(xmpp_stanza_t *const stanza, void *const userda
     const char *from = xmpp_stanza_get_from(stanza);
     if (!from) {
         log_info("No from attribute");
+        _caps_request_next(expected_node, TRUE);
         free(expected_node);
         return 0;
     }
@@ -850,12 +896,14 @@ _caps_response_legacy_id_handler(xmpp_stanza_t *const stanza, void *const userda
         char *error_message = stanza_get_error_message(stanza);
         log_warning("Error received for capabilities response from %s: ", from, error_message);
         free(error_message);
+        _caps_request_next(expected_node, TRUE);
         free(expected_node);
         return 0;
     }
 
     if (query == NULL) {
         log_info("No query element found.");
+        _caps_request_next(expected_node, TRUE);
         free(expected_node);
         return 0;
     }
@@ -863,6 +911,7 @@ _caps_response_legacy_id_handler(xmpp_stanza_t *const stanza, void *const userda
     const char *node = xmpp_stanza_get_attribute(query, STANZA_ATTR_NODE);
     if (node == NULL) {
         log_info("No node attribute found");
+        _caps_request_next(expected_node, TRUE);
         free(expected_node);
         return 0;
     }
@@ -880,10 +929,12 @@ _caps_response_legacy_id_handler(xmpp_stanza_t *const stanza, void *const userda
         }
 
         caps_map_jid_to_ver(from, node);
+        caps_pending_resolve(node);
 
     // node match fail
     } else {
         log_info("Legacy Capabilities nodes do not match, expeceted %s, given %s.", expected_node, node);
+        _caps_request_next(expected_node, TRUE);
     }
 
     free(expected_node);
@@ -1964,8 +2015,7 @@ _http_upload_response_id_handler(xmpp_stanza_t *const stanza, void *const userda
             if (put_url) xmpp_free(ctx, put_url);
             if (get_url) xmpp_free(ctx, get_url);
 
-            pthread_create(&(upload->worker), NULL, &http_file_put, upload);
-            upload_processes = g_slist_append(upload_processes, upload);
+            http_upload_start(upload);
         } else {
             log_error("Invalid XML in HTTP Upload slot");
             return 1;
@@ -40,8 +40,104 @@
 #include "common.h"
 #include "xmpp/jid.h"
 
+#define JID_CACHE_SIZE 256
+
+// parsed jids by string, most recently used at the head of jid_lru
+static GHashTable *jid_cache = NULL;
+static GQueue *jid_lru = NULL;
+
+static Jid* _jid_parse(const gchar *const str);
+
 Jid*
 jid_create(const gchar *const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    if (jid_cache == NULL) {
+        jid_cache = g_hash_table_new(g_str_hash, g_str_equal);
+        jid_lru = g_queue_new();
+    }
+
+    GList *link = g_hash_table_lookup(jid_cache, str);
+    if (link) {
+        g_queue_unlink(jid_lru, link);
+        g_queue_push_head_link(jid_lru, link);
+        return jid_ref(link->data);
+    }
+
+    Jid *result = _jid_parse(str);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    // the cache holds its own reference, keyed by the jids own copy of str
+    g_queue_push_head(jid_lru, jid_ref(result));
+    g_hash_table_insert(jid_cache, result->str, jid_lru->head);
+
+    if (g_queue_get_length(jid_lru) > JID_CACHE_SIZE) {
+        Jid *oldest = g_queue_pop_tail(jid_lru);
+        g_hash_table_remove(jid_cache, oldest->str);
+        jid_destroy(oldest);
+    }
+
+    return result;
+}
+
+Jid*
+jid_ref(Jid *jid)
+{
+    if (jid) {
+        jid->refcount++;
+    }
+
+    return jid;
+}
+
+void
+jid_cache_clear(void)
+{
+    if (jid_cache == NULL) {
+        return;
+    }
+
+    g_hash_table_destroy(jid_cache);
+    jid_cache = NULL;
+    while (!g_queue_is_empty(jid_lru)) {
+        jid_destroy(g_queue_pop_head(jid_lru));
+    }
+    g_queue_free(jid_lru);
+    jid_lru = NULL;
+}
+
+gboolean
+jid_bare_equals(const char *const jid, const char *const barejid)
+{
+    if (jid == NULL || barejid == NULL || jid[0] == '\0' || jid[0] == '/' || jid[0] == '@') {
+        return FALSE;
+    }
+
+    // compare the bare part in place, lowering ASCII as jid_create would
+    int i = 0;
+    while (jid[i] != '\0' && jid[i] != '/') {
+        if ((jid[i] & 0x80) || (barejid[i] & 0x80)) {
+            Jid *jidp = jid_create(jid);
+            gboolean result = jidp && g_strcmp0(jidp->barejid, barejid) == 0;
+            jid_destroy(jidp);
+            return result;
+        }
+        if (g_ascii_tolower(jid[i]) != barejid[i]) {
+            return FALSE;
+        }
+        i++;
+    }
+
+    return barejid[i] == '\0';
+}
+
+static Jid*
+_jid_parse(const gchar *const str)
 {
     Jid *result = NULL;
 
@@ -51,22 +147,26 @@ jid_create(const gchar *const str)
         return NULL;
     }
 
-    if (strlen(trimmed) == 0) {
+    size_t len = strlen(trimmed);
+    if (len == 0) {
         g_free(trimmed);
         return NULL;
     }
 
-    if (g_str_has_prefix(trimmed, "/") || g_str_has_prefix(trimmed, "@")) {
+    if (trimmed[0] == '/' || trimmed[0] == '@') {
         g_free(trimmed);
         return NULL;
     }
 
-    if (!g_utf8_validate(trimmed, -1, NULL)) {
+    // most jids are plain ASCII, which is valid UTF-8 and can be lowered bytewise
+    gboolean ascii = utf8_ascii_prefix_len(trimmed, len) == len;
+    if (!ascii && !g_utf8_validate(trimmed, len, NULL)) {
         g_free(trimmed);
         return NULL;
     }
 
     result = malloc(sizeof(struct jid_t));
+    result->refcount = 1;
     result->str = NULL;
     result->localpart = NULL;
     result->domainpart = NULL;
@@ -74,25 +174,34 @@ jid_create(const gchar *const str)
     result->barejid = NULL;
     result->fulljid = NULL;
 
-    gchar *atp = g_utf8_strchr(trimmed, -1, '@');
-    gchar *slashp = g_utf8_strchr(trimmed, -1, '/');
+    // '@' and '/' are single bytes in UTF-8 so can be searched for bytewise
+    gchar *atp = strchr(trimmed, '@');
+    gchar *slashp = strchr(trimmed, '/');
     gchar *domain_start = trimmed;
 
     if (atp) {
-        result->localpart = g_utf8_substring(trimmed, 0, g_utf8_pointer_to_offset(trimmed, atp));
+        result->localpart = g_strndup(trimmed, atp - trimmed);
         domain_start = atp + 1;
     }
 
     if (slashp) {
         result->resourcepart = g_strdup(slashp + 1);
-        result->domainpart = g_utf8_substring(domain_start, 0, g_utf8_pointer_to_offset(domain_start, slashp));
-        char *barejidraw = g_utf8_substring(trimmed, 0, g_utf8_pointer_to_offset(trimmed, slashp));
-        result->barejid = g_utf8_strdown(barejidraw, -1);
+        if (slashp >= domain_start) {
+            result->domainpart = g_strndup(domain_start, slashp - domain_start);
+        } else {
+            result->domainpart = g_utf8_substring(domain_start, 0, g_utf8_pointer_to_offset(domain_start, slashp));
+        }
+        if (ascii) {
+            result->barejid = g_ascii_strdown(trimmed, slashp - trimmed);
+        } else {
+            char *barejidraw = g_strndup(trimmed, slashp - trimmed);
+            result->barejid = g_utf8_strdown(barejidraw, -1);
+            g_free(barejidraw);
+        }
         result->fulljid = g_strdup(trimmed);
-        g_free(barejidraw);
     } else {
         result->domainpart = g_strdup(domain_start);
-        result->barejid = g_utf8_strdown(trimmed, -1);
+        result->barejid = ascii ? g_ascii_strdown(trimmed, len) : g_utf8_strdown(trimmed, len);
     }
 
     if (result->domainpart == NULL) {
@@ -123,6 +232,11 @@ jid_destroy(Jid *jid)
         return;
     }
 
+    jid->refcount--;
+    if (jid->refcount > 0) {
+        return;
+    }
+
     g_free(jid->str);
     g_free(jid->localpart);
     g_free(jid->domainpart);
@@ -37,7 +37,9 @@
 
 #include <glib.h>
 
+// jids returned by jid_create are shared through a cache and must not be modified
 struct jid_t {
+    int refcount;
     char *str;
     char *localpart;
     char *domainpart;
@@ -50,7 +52,10 @@ typedef struct jid_t Jid;
 
 Jid* jid_create(const gchar *const str);
 Jid* jid_create_from_bare_and_resource(const char *const room, const char *const nick);
+Jid* jid_ref(Jid *jid);
 void jid_destroy(Jid *jid);
+void jid_cache_clear(void);
+gboolean jid_bare_equals(const char *const jid, const char *const barejid);
 
 gboolean jid_is_valid_room_form(Jid *jid);
 char* create_fulljid(const char *const barejid, const char *const resource);
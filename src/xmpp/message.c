@@ -74,18 +74,35 @@ static void _handle_chat(xmpp_stanza_t *const stanza);
 
 static void _send_message_stanza(xmpp_stanza_t *const stanza);
 
+static ProfDispatch *ns_handlers;
+
+static void
+_ns_handlers_init(void)
+{
+    if (ns_handlers) {
+        return;
+    }
+
+    ns_handlers = dispatch_new();
+    dispatch_add(ns_handlers, STANZA_NS_MUC_USER, NULL, _handel_muc_user);
+    dispatch_add(ns_handlers, STANZA_NS_CONFERENCE, NULL, _handle_conference);
+    dispatch_add(ns_handlers, STANZA_NS_CAPTCHA, NULL, _handle_captcha);
+    dispatch_add(ns_handlers, STANZA_NS_RECEIPTS, NULL, _handle_receipt_received);
+}
+
 static int
 _message_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *const userdata)
 {
     log_debug("Message stanza handler fired");
 
-    char *text;
-    size_t text_size;
-    xmpp_stanza_to_text(stanza, &text, &text_size);
-    gboolean cont = plugins_on_message_stanza_receive(text);
-    xmpp_free(connection_get_ctx(), text);
-    if (!cont) {
-        return 1;
+    if (plugins_has_hook(HOOK_ON_MESSAGE_STANZA_RECEIVE)) {
+        gboolean cont = plugins_on_message_stanza_receive(connection_stanza_text(stanza));
+        if (!cont) {
+            connection_stanza_done();
+            return 1;
+        }
+    } else {
+        connection_stanza_text_skipped();
     }
 
     const char *type = xmpp_stanza_get_type(stanza);
@@ -98,28 +115,12 @@ _message_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *con
         _handle_groupchat(stanza);
     }
 
-    xmpp_stanza_t *mucuser = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_MUC_USER);
-    if (mucuser) {
-        _handel_muc_user(stanza);
-    }
-
-    xmpp_stanza_t *conference = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_CONFERENCE);
-    if (conference) {
-        _handle_conference(stanza);
-    }
-
-    xmpp_stanza_t *captcha = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_CAPTCHA);
-    if (captcha) {
-        _handle_captcha(stanza);
-    }
-
-    xmpp_stanza_t *receipts = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_RECEIPTS);
-    if (receipts) {
-        _handle_receipt_received(stanza);
-    }
+    dispatch_stanza(ns_handlers, stanza, type);
 
     _handle_chat(stanza);
 
+    connection_stanza_done();
+
     return 1;
 }
 
@@ -129,6 +130,28 @@ message_handlers_init(void)
     xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_handler_add(conn, _message_handler, NULL, STANZA_NAME_MESSAGE, NULL, ctx);
+
+    _ns_handlers_init();
+}
+
+void
+message_ns_handler_add(const char *const ns, const char *const type, ProfNsCallback func)
+{
+    _ns_handlers_init();
+    dispatch_add(ns_handlers, ns, type, func);
+}
+
+void
+message_ns_handler_remove(const char *const ns, const char *const type, ProfNsCallback func)
+{
+    dispatch_remove(ns_handlers, ns, type, func);
+}
+
+void
+message_handlers_clear(void)
+{
+    dispatch_free(ns_handlers);
+    ns_handlers = NULL;
 }
 
 char*
@@ -163,24 +186,26 @@ message_send_chat(const char *const barejid, const char *const msg, const char *
     return id;
 }
 
-char*
-message_send_chat_pgp(const char *const barejid, const char *const msg, gboolean request_receipt)
-{
-    xmpp_ctx_t * const ctx = connection_get_ctx();
+#ifdef HAVE_LIBGPGME
+// a chat message waiting for its body to be encrypted
+struct pgp_send_t {
+    char *barejid;
+    char *jid;
+    char *id;
+    char *msg;
+    char *state;
+    gboolean request_receipt;
+};
 
-    char *state = chat_session_get_state(barejid);
-    char *jid = chat_session_get_jid(barejid);
-    char *id = create_unique_id("msg");
+static void
+_message_send_chat_pgp_encrypted(const char *const encrypted, void *userdata)
+{
+    struct pgp_send_t *send = userdata;
 
-    xmpp_stanza_t *message = NULL;
-#ifdef HAVE_LIBGPGME
-    char *account_name = session_get_account_name();
-    ProfAccount *account = accounts_get_account(account_name);
-    if (account->pgp_keyid) {
-        Jid *jidp = jid_create(jid);
-        char *encrypted = p_gpg_encrypt(jidp->barejid, msg, account->pgp_keyid);
+    if (connection_get_status() == JABBER_CONNECTED) {
+        xmpp_ctx_t * const ctx = connection_get_ctx();
+        xmpp_stanza_t *message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, send->jid, send->id);
         if (encrypted) {
-            message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
             xmpp_message_set_body(message, "This message is encrypted.");
             xmpp_stanza_t *x = xmpp_stanza_new(ctx);
             xmpp_stanza_set_name(x, STANZA_NAME_X);
@@ -191,21 +216,70 @@ message_send_chat_pgp(const char *const barejid, const char *const msg, gboolean
             xmpp_stanza_release(enc_st);
             xmpp_stanza_add_child(message, x);
             xmpp_stanza_release(x);
-            free(encrypted);
         } else {
-            message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-            xmpp_message_set_body(message, msg);
+            xmpp_message_set_body(message, send->msg);
+        }
+
+        if (send->state) {
+            stanza_attach_state(ctx, message, send->state);
+        }
+
+        if (send->request_receipt) {
+            stanza_attach_receipt_request(ctx, message);
+        }
+
+        _send_message_stanza(message);
+        xmpp_stanza_release(message);
+
+        // shown as pending until sent, unless it waits for a receipt anyway
+        if (!send->request_receipt) {
+            sv_ev_message_receipt(send->barejid, send->id);
         }
-        jid_destroy(jidp);
     } else {
-        message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-        xmpp_message_set_body(message, msg);
+        log_warning("Dropping encrypted message to %s, disconnected", send->jid);
+    }
+
+    free(send->barejid);
+    free(send->jid);
+    free(send->id);
+    free(send->msg);
+    free(send->state);
+    free(send);
+}
+#endif
+
+char*
+message_send_chat_pgp(const char *const barejid, const char *const msg, gboolean request_receipt)
+{
+    xmpp_ctx_t * const ctx = connection_get_ctx();
+
+    char *state = chat_session_get_state(barejid);
+    char *jid = chat_session_get_jid(barejid);
+    char *id = create_unique_id("msg");
+
+#ifdef HAVE_LIBGPGME
+    char *account_name = session_get_account_name();
+    ProfAccount *account = accounts_get_account(account_name);
+    if (account->pgp_keyid) {
+        // encrypted on the pgp worker, sent from _message_send_chat_pgp_encrypted
+        Jid *jidp = jid_create(jid);
+        struct pgp_send_t *send = malloc(sizeof(struct pgp_send_t));
+        send->barejid = strdup(barejid);
+        send->jid = jid;
+        send->id = strdup(id);
+        send->msg = strdup(msg);
+        send->state = state ? strdup(state) : NULL;
+        send->request_receipt = request_receipt;
+        p_gpg_encrypt_async(jidp->barejid, msg, account->pgp_keyid, _message_send_chat_pgp_encrypted, send);
+        jid_destroy(jidp);
+        account_free(account);
+        return id;
     }
     account_free(account);
-#else
-    message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-    xmpp_message_set_body(message, msg);
 #endif
+
+    xmpp_stanza_t *message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
+    xmpp_message_set_body(message, msg);
     free(jid);
 
     if (state) {
@@ -519,7 +593,9 @@ _handle_groupchat(xmpp_stanza_t *const stanza)
     xmpp_ctx_t *ctx = connection_get_ctx();
     char *message = NULL;
     const char *room_jid = xmpp_stanza_get_from(stanza);
+    Arena arena = connection_stanza_arena();
     Jid *jid = jid_create(room_jid);
+    arena_own(arena, jid, (GDestroyNotify)jid_destroy);
 
     // handle room subject
     xmpp_stanza_t *subject = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_SUBJECT);
@@ -527,8 +603,6 @@ _handle_groupchat(xmpp_stanza_t *const stanza)
         message = xmpp_stanza_get_text(subject);
         sv_ev_room_subject(jid->barejid, jid->resourcepart, message);
         xmpp_free(ctx, message);
-
-        jid_destroy(jid);
         return;
     }
 
@@ -536,47 +610,40 @@ _handle_groupchat(xmpp_stanza_t *const stanza)
     if (!jid->resourcepart) {
         message = xmpp_message_get_body(stanza);
         if (!message) {
-            jid_destroy(jid);
             return;
         }
 
         sv_ev_room_broadcast(room_jid, message);
         xmpp_free(ctx, message);
-
-        jid_destroy(jid);
         return;
     }
 
     if (!jid_is_valid_room_form(jid)) {
         log_error("Invalid room JID: %s", jid->str);
-        jid_destroy(jid);
         return;
     }
 
     // room not active in profanity
     if (!muc_active(jid->barejid)) {
         log_error("Message received for inactive chat room: %s", jid->str);
-        jid_destroy(jid);
         return;
     }
 
     message = xmpp_message_get_body(stanza);
     if (!message) {
-        jid_destroy(jid);
         return;
     }
 
     // determine if the notifications happened whilst offline
     GDateTime *timestamp = stanza_get_delay(stanza);
     if (timestamp) {
+        arena_own(arena, timestamp, (GDestroyNotify)g_date_time_unref);
         sv_ev_room_history(jid->barejid, jid->resourcepart, timestamp, message);
-        g_date_time_unref(timestamp);
     } else {
         sv_ev_room_message(jid->barejid, jid->resourcepart, message);
     }
 
     xmpp_free(ctx, message);
-    jid_destroy(jid);
 }
 
 void
@@ -722,7 +789,6 @@ _handle_carbons(xmpp_stanza_t *const stanza)
 
     Jid *jid_from = jid_create(from);
     Jid *jid_to = jid_create(to);
-    Jid *my_jid = jid_create(connection_get_fulljid());
 
     // check for pgp encrypted message
     char *enc_message = NULL;
@@ -732,7 +798,7 @@ _handle_carbons(xmpp_stanza_t *const stanza)
     }
 
     // if we are the recipient, treat as standard incoming message
-    if (g_strcmp0(my_jid->barejid, jid_to->barejid) == 0) {
+    if (jid_bare_equals(connection_get_fulljid(), jid_to->barejid)) {
         sv_ev_incoming_carbon(jid_from->barejid, jid_from->resourcepart, message_txt, enc_message);
 
     // else treat as a sent message
@@ -746,7 +812,6 @@ _handle_carbons(xmpp_stanza_t *const stanza)
 
     jid_destroy(jid_from);
     jid_destroy(jid_to);
-    jid_destroy(my_jid);
 
     return TRUE;
 }
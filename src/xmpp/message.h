@@ -35,6 +35,11 @@
 #ifndef XMPP_MESSAGE_H
 #define XMPP_MESSAGE_H
 
+#include "xmpp/dispatch.h"
+
 void message_handlers_init(void);
+void message_handlers_clear(void);
+void message_ns_handler_add(const char *const ns, const char *const type, ProfNsCallback func);
+void message_ns_handler_remove(const char *const ns, const char *const type, ProfNsCallback func);
 
 #endif
@@ -40,6 +40,7 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/jid.h"
@@ -56,6 +57,8 @@ typedef struct _muc_room_t {
     char *autocomplete_prefix;
     gboolean pending_config;
     GList *pending_broadcasts;
+    GQueue *pending_history;
+    gint64 pending_history_since;
     gboolean autojoin;
     gboolean pending_nick_change;
     GHashTable *roster;
@@ -66,6 +69,9 @@ typedef struct _muc_room_t {
     muc_member_type_t member_type;
 } ChatRoom;
 
+// history replayed on join is shown in one batch, at the latest after this long
+#define MUC_HISTORY_FLUSH_TIMEOUT (2 * G_USEC_PER_SEC)
+
 GHashTable *rooms = NULL;
 GHashTable *invite_passwords = NULL;
 Autocomplete invite_ac;
@@ -187,11 +193,14 @@ muc_join(const char *const room, const char *const nick, const char *const passw
     }
     new_room->subject = NULL;
     new_room->pending_broadcasts = NULL;
+    new_room->pending_history = g_queue_new();
+    new_room->pending_history_since = 0;
     new_room->pending_config = FALSE;
     new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_occupant_free);
-    new_room->nick_ac = autocomplete_new();
+    new_room->nick_ac = autocomplete_new_interned();
     new_room->jid_ac = autocomplete_new();
-    new_room->nick_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    new_room->nick_changes = g_hash_table_new_full(g_str_hash, g_str_equal,
+        (GDestroyNotify)intern_unref, (GDestroyNotify)intern_unref);
     new_room->roster_received = FALSE;
     new_room->pending_nick_change = FALSE;
     new_room->autojoin = autojoin;
@@ -306,6 +315,73 @@ muc_pending_broadcasts(const char *const room)
     }
 }
 
+void
+muc_pending_history_add(const char *const room, const char *const nick, GDateTime *timestamp,
+    const char *const message)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room == NULL) {
+        return;
+    }
+
+    MucHistory *history = malloc(sizeof(MucHistory));
+    history->nick = strdup(nick);
+    history->message = strdup(message);
+    history->timestamp = g_date_time_ref(timestamp);
+
+    if (g_queue_is_empty(chat_room->pending_history)) {
+        chat_room->pending_history_since = g_get_monotonic_time();
+    }
+    g_queue_push_tail(chat_room->pending_history, history);
+}
+
+GList*
+muc_pending_history_take(const char *const room)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room == NULL) {
+        return NULL;
+    }
+
+    GList *history = g_list_copy(chat_room->pending_history->head);
+    g_queue_clear(chat_room->pending_history);
+
+    return history;
+}
+
+// rooms whose joined history has waited too long, the caller frees the list and the names
+GList*
+muc_pending_history_expired(void)
+{
+    GList *result = NULL;
+    gint64 now = g_get_monotonic_time();
+
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, rooms);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ChatRoom *chat_room = value;
+        if (!g_queue_is_empty(chat_room->pending_history) &&
+                now - chat_room->pending_history_since > MUC_HISTORY_FLUSH_TIMEOUT) {
+            result = g_list_append(result, strdup(key));
+        }
+    }
+
+    return result;
+}
+
+void
+muc_history_free(MucHistory *history)
+{
+    if (history) {
+        free(history->nick);
+        free(history->message);
+        g_date_time_unref(history->timestamp);
+        free(history);
+    }
+}
+
 char*
 muc_old_nick(const char *const room, const char *const new_nick)
 {
@@ -327,7 +403,7 @@ muc_nick_change_start(const char *const room, const char *const new_nick)
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
         chat_room->pending_nick_change = TRUE;
-        g_hash_table_insert(chat_room->nick_changes, strdup(new_nick), strdup(chat_room->nick));
+        g_hash_table_insert(chat_room->nick_changes, intern_ref(new_nick), intern_ref(chat_room->nick));
     }
 }
 
@@ -634,7 +710,7 @@ muc_occupant_nick_change_start(const char *const room, const char *const new_nic
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        g_hash_table_insert(chat_room->nick_changes, strdup(new_nick), strdup(old_nick));
+        g_hash_table_insert(chat_room->nick_changes, intern_ref(new_nick), intern_ref(old_nick));
         muc_roster_remove(room, old_nick);
     }
 }
@@ -825,6 +901,10 @@ _free_room(ChatRoom *room)
         if (room->pending_broadcasts) {
             g_list_free_full(room->pending_broadcasts, free);
         }
+        while (!g_queue_is_empty(room->pending_history)) {
+            muc_history_free(g_queue_pop_head(room->pending_history));
+        }
+        g_queue_free(room->pending_history);
         free(room);
     }
 }
@@ -940,7 +1020,7 @@ _muc_occupant_new(const char *const nick, const char *const jid, muc_role_t role
     Occupant *occupant = malloc(sizeof(Occupant));
 
     if (nick) {
-        occupant->nick = strdup(nick);
+        occupant->nick = intern_ref(nick);
         occupant->nick_collate_key = g_utf8_collate_key(occupant->nick, -1);
     } else {
         occupant->nick = NULL;
@@ -948,7 +1028,7 @@ _muc_occupant_new(const char *const nick, const char *const jid, muc_role_t role
     }
 
     if (jid) {
-        occupant->jid = strdup(jid);
+        occupant->jid = intern_ref(jid);
     } else {
         occupant->jid = NULL;
     }
@@ -971,9 +1051,9 @@ static void
 _occupant_free(Occupant *occupant)
 {
     if (occupant) {
-        free(occupant->nick);
+        intern_unref(occupant->nick);
         free(occupant->nick_collate_key);
-        free(occupant->jid);
+        intern_unref(occupant->jid);
         free(occupant->status);
         free(occupant);
     }
@@ -73,6 +73,12 @@ typedef struct _muc_occupant_t {
     char *status;
 } Occupant;
 
+typedef struct _muc_history_t {
+    char *nick;
+    char *message;
+    GDateTime *timestamp;
+} MucHistory;
+
 void muc_init(void);
 void muc_close(void);
 
@@ -133,6 +139,12 @@ char* muc_subject(const char *const room);
 void muc_pending_broadcasts_add(const char *const room, const char *const message);
 GList* muc_pending_broadcasts(const char *const room);
 
+void muc_pending_history_add(const char *const room, const char *const nick, GDateTime *timestamp,
+    const char *const message);
+GList* muc_pending_history_take(const char *const room);
+GList* muc_pending_history_expired(void);
+void muc_history_free(MucHistory *history);
+
 char* muc_autocomplete(ProfWin *window, const char *const input);
 void muc_autocomplete_reset(const char *const room);
 
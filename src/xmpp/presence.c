@@ -359,14 +359,14 @@ _presence_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *co
 {
     log_debug("Presence stanza handler fired");
 
-    char *text = NULL;
-    size_t text_size;
-    xmpp_stanza_to_text(stanza, &text, &text_size);
-
-    gboolean cont = plugins_on_presence_stanza_receive(text);
-    xmpp_free(connection_get_ctx(), text);
-    if (!cont) {
-        return 1;
+    if (plugins_has_hook(HOOK_ON_PRESENCE_STANZA_RECEIVE)) {
+        gboolean cont = plugins_on_presence_stanza_receive(connection_stanza_text(stanza));
+        if (!cont) {
+            connection_stanza_done();
+            return 1;
+        }
+    } else {
+        connection_stanza_text_skipped();
     }
 
     const char *type = xmpp_stanza_get_type(stanza);
@@ -398,6 +398,8 @@ _presence_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *co
 
     _available_handler(stanza);
 
+    connection_stanza_done();
+
     return 1;
 }
 
@@ -428,6 +430,7 @@ _presence_error_handler(xmpp_stanza_t *const stanza)
         log_info("Error joining room: %s, reason: %s", fulljid->barejid, error_cond);
         if (muc_active(fulljid->barejid)) {
             muc_leave(fulljid->barejid);
+            sv_ev_room_matcher_remove(fulljid->barejid);
         }
         cons_show_error("Error joining room %s, reason: %s", fulljid->barejid, error_cond);
         jid_destroy(fulljid);
@@ -578,6 +581,8 @@ _handle_caps(const char *const jid, XMPPCaps *caps)
             if (caps_cache_contains(caps->ver)) {
                 log_info("Capabilities cache hit: %s, for %s.", caps->ver, jid);
                 caps_map_jid_to_ver(jid, caps->ver);
+            } else if (caps_pending_add(caps->ver, jid, caps->node, caps->ver)) {
+                log_info("Capabilities cache miss: %s, for %s, request already pending", caps->ver, jid);
             } else {
                 log_info("Capabilities cache miss: %s, for %s, sending service discovery request", caps->ver, jid);
                 char *id = create_unique_id("caps");
@@ -595,10 +600,19 @@ _handle_caps(const char *const jid, XMPPCaps *caps)
 
    // no hash, legacy caps, cache against node#ver
    } else if (caps->node && caps->ver) {
-        log_info("No hash specified: %s, legacy request made for %s#%s", jid, caps->node, caps->ver);
-        char *id = create_unique_id("caps");
-        iq_send_caps_request_legacy(jid, id, caps->node, caps->ver);
-        free(id);
+        char *node_ver = g_strdup_printf("%s#%s", caps->node, caps->ver);
+        if (caps_cache_contains(node_ver)) {
+            log_info("Capabilities cache hit: %s, for %s.", node_ver, jid);
+            caps_map_jid_to_ver(jid, node_ver);
+        } else if (caps_pending_add(node_ver, jid, caps->node, caps->ver)) {
+            log_info("No hash specified: %s, legacy request already pending for %s", jid, node_ver);
+        } else {
+            log_info("No hash specified: %s, legacy request made for %s", jid, node_ver);
+            char *id = create_unique_id("caps");
+            iq_send_caps_request_legacy(jid, id, caps->node, caps->ver);
+            free(id);
+        }
+        g_free(node_ver);
     } else {
         log_info("No hash specified: %s, could not create ver string, not sending service discovery request.", jid);
     }
@@ -629,6 +643,7 @@ _available_handler(xmpp_stanza_t *const stanza)
 
     int err = 0;
     XMPPPresence *xmpp_presence = stanza_parse_presence(stanza, &err);
+    Arena arena = connection_stanza_arena();
 
     if (!xmpp_presence) {
         const char *from = NULL;
@@ -648,11 +663,13 @@ _available_handler(xmpp_stanza_t *const stanza)
     } else {
         char *jid = jid_fulljid_or_barejid(xmpp_presence->jid);
         log_debug("Presence available handler fired for: %s", jid);
+        arena_own(arena, xmpp_presence, (GDestroyNotify)stanza_free_presence);
     }
 
     xmpp_conn_t *conn = connection_get_conn();
     const char *my_jid_str = xmpp_conn_get_jid(conn);
     Jid *my_jid = jid_create(my_jid_str);
+    arena_own(arena, my_jid, (GDestroyNotify)jid_destroy);
 
     XMPPCaps *caps = stanza_parse_caps(stanza);
     if ((g_strcmp0(my_jid->fulljid, xmpp_presence->jid->fulljid) != 0) && caps) {
@@ -676,9 +693,6 @@ _available_handler(xmpp_stanza_t *const stanza)
         xmpp_ctx_t *ctx = connection_get_ctx();
         xmpp_free(ctx, pgpsig);
     }
-
-    jid_destroy(my_jid);
-    stanza_free_presence(xmpp_presence);
 }
 
 void
@@ -37,6 +37,7 @@
 #include <string.h>
 
 #include "common.h"
+#include "tools/intern.h"
 #include "xmpp/resource.h"
 
 Resource*
@@ -44,7 +45,7 @@ resource_new(const char *const name, resource_presence_t presence, const char *c
 {
     assert(name != NULL);
     Resource *new_resource = malloc(sizeof(struct resource_t));
-    new_resource->name = strdup(name);
+    new_resource->name = intern_ref(name);
     new_resource->presence = presence;
     if (status) {
         new_resource->status = strdup(status);
@@ -90,7 +91,7 @@ void
 resource_destroy(Resource *resource)
 {
     if (resource) {
-        free(resource->name);
+        intern_unref(resource->name);
         free(resource->status);
         free(resource);
     }
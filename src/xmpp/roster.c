@@ -217,13 +217,10 @@ roster_set_handler(xmpp_stanza_t *const stanza)
     }
 
     // if from attribute exists and it is not current users barejid, ignore push
-    Jid *my_jid = jid_create(connection_get_fulljid());
     const char *from = xmpp_stanza_get_from(stanza);
-    if (from && (strcmp(from, my_jid->barejid) != 0)) {
-        jid_destroy(my_jid);
+    if (from && !jid_bare_equals(connection_get_fulljid(), from)) {
         return;
     }
-    jid_destroy(my_jid);
 
     const char *barejid = xmpp_stanza_get_attribute(item, STANZA_ATTR_JID);
     gchar *barejid_lower = g_utf8_strdown(barejid, -1);
@@ -41,6 +41,7 @@
 
 #include "config/preferences.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
 #include "xmpp/roster_list.h"
 #include "xmpp/resource.h"
 #include "xmpp/contact.h"
@@ -83,10 +84,11 @@ roster_create(void)
 
     roster = malloc(sizeof(ProfRoster));
     roster->contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free, (GDestroyNotify)p_contact_free);
-    roster->name_ac = autocomplete_new();
+    roster->name_ac = autocomplete_new_interned();
     roster->barejid_ac = autocomplete_new();
     roster->fulljid_ac = autocomplete_new();
-    roster->name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    roster->name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal,
+        (GDestroyNotify)intern_unref, (GDestroyNotify)intern_unref);
     roster->groups_ac = autocomplete_new();
     roster->group_count = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 }
@@ -598,10 +600,10 @@ _add_name_and_barejid(const char *const name, const char *const barejid)
 
     if (name) {
         autocomplete_add(roster->name_ac, name);
-        g_hash_table_insert(roster->name_to_barejid, strdup(name), strdup(barejid));
+        g_hash_table_insert(roster->name_to_barejid, intern_ref(name), intern_ref(barejid));
     } else {
         autocomplete_add(roster->name_ac, barejid);
-        g_hash_table_insert(roster->name_to_barejid, strdup(barejid), strdup(barejid));
+        g_hash_table_insert(roster->name_to_barejid, intern_ref(barejid), intern_ref(barejid));
     }
 }
 
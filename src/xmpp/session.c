@@ -108,6 +108,8 @@ session_connect_with_account(const ProfAccount *const account)
 
     log_info("Connecting using account: %s", account->name);
 
+    connection_sm_reset();
+
     // save account name and password for reconnect
     if (saved_account.name) {
         free(saved_account.name);
@@ -171,6 +173,8 @@ session_connect_with_details(const char *const jid, const char *const passwd, co
     // connect with fulljid
     log_info("Connecting without account, JID: %s", saved_details.jid);
 
+    connection_sm_reset();
+
     return connection_connect(
         saved_details.jid,
         passwd,
@@ -213,6 +217,7 @@ session_disconnect(void)
         accounts_set_last_activity(session_get_account_name());
 
         connection_disconnect();
+        connection_sm_reset();
 
         _session_free_saved_account();
         _session_free_saved_details();
@@ -235,6 +240,9 @@ session_shutdown(void)
     chat_sessions_clear();
     presence_clear_sub_requests();
 
+    iq_handlers_clear();
+    message_handlers_clear();
+
     connection_shutdown();
     if (saved_status) {
         free(saved_status);
@@ -66,6 +66,7 @@
 #include "xmpp/muc.h"
 
 static void _stanza_add_unique_id(xmpp_stanza_t *stanza, char *prefix);
+static void _stanza_append_escaped(GString *buf, const char *text);
 
 #if 0
 xmpp_stanza_t*
@@ -1953,6 +1954,63 @@ stanza_text_strdup(xmpp_stanza_t *stanza)
     return string;
 }
 
+void
+stanza_append_text(xmpp_stanza_t *const stanza, GString *buf)
+{
+    if (xmpp_stanza_is_text(stanza)) {
+        const char *text = xmpp_stanza_get_text_ptr(stanza);
+        if (text) {
+            _stanza_append_escaped(buf, text);
+        }
+        return;
+    }
+
+    const char *name = xmpp_stanza_get_name(stanza);
+    if (name == NULL) {
+        return;
+    }
+
+    g_string_append_c(buf, '<');
+    g_string_append(buf, name);
+
+    int count = xmpp_stanza_get_attribute_count(stanza);
+    if (count > 0) {
+        const char *stack_attrs[32];
+        const char **attrs = stack_attrs;
+        int attrs_len = count * 2;
+        if (attrs_len > 32) {
+            attrs = malloc(sizeof(char*) * attrs_len);
+        }
+        int filled = xmpp_stanza_get_attributes(stanza, attrs, attrs_len);
+        int i;
+        for (i = 0; i + 1 < filled; i += 2) {
+            g_string_append_c(buf, ' ');
+            g_string_append(buf, attrs[i]);
+            g_string_append(buf, "=\"");
+            _stanza_append_escaped(buf, attrs[i+1]);
+            g_string_append_c(buf, '"');
+        }
+        if (attrs != stack_attrs) {
+            free(attrs);
+        }
+    }
+
+    xmpp_stanza_t *child = xmpp_stanza_get_children(stanza);
+    if (child == NULL) {
+        g_string_append(buf, "/>");
+        return;
+    }
+
+    g_string_append_c(buf, '>');
+    while (child) {
+        stanza_append_text(child, buf);
+        child = xmpp_stanza_get_next(child);
+    }
+    g_string_append(buf, "</");
+    g_string_append(buf, name);
+    g_string_append_c(buf, '>');
+}
+
 void
 stanza_free_caps(XMPPCaps *caps)
 {
@@ -2045,3 +2103,28 @@ _stanza_add_unique_id(xmpp_stanza_t *stanza, char *prefix)
     xmpp_stanza_set_id(stanza, id);
     free(id);
 }
+
+static void
+_stanza_append_escaped(GString *buf, const char *text)
+{
+    const char *curr;
+    for (curr = text; *curr; curr++) {
+        switch (*curr) {
+        case '&':
+            g_string_append(buf, "&amp;");
+            break;
+        case '<':
+            g_string_append(buf, "&lt;");
+            break;
+        case '>':
+            g_string_append(buf, "&gt;");
+            break;
+        case '"':
+            g_string_append(buf, "&quot;");
+            break;
+        default:
+            g_string_append_c(buf, *curr);
+            break;
+        }
+    }
+}
@@ -316,6 +316,7 @@ XMPPPresence* stanza_parse_presence(xmpp_stanza_t *stanza, int *err);
 void stanza_free_presence(XMPPPresence *presence);
 
 char* stanza_text_strdup(xmpp_stanza_t *stanza);
+void stanza_append_text(xmpp_stanza_t *const stanza, GString *buf);
 
 XMPPCaps* stanza_parse_caps(xmpp_stanza_t *const stanza);
 void stanza_free_caps(XMPPCaps *caps);
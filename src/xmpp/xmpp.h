@@ -47,6 +47,7 @@
 
 #include "config/accounts.h"
 #include "config/tlscerts.h"
+#include "tools/arena.h"
 #include "tools/autocomplete.h"
 #include "tools/http_upload.h"
 #include "xmpp/contact.h"
@@ -101,6 +102,7 @@ typedef struct entity_capabilities_t {
     DiscoIdentity *identity;
     SoftwareVersion *software_version;
     GSList *features;
+    int refcount;
 } EntityCapabilities;
 
 typedef struct disco_item_t {
@@ -120,6 +122,8 @@ char* session_get_account_name(void);
 jabber_conn_status_t connection_get_status(void);
 char *connection_get_presence_msg(void);
 const char* connection_get_fulljid(void);
+Arena connection_stanza_arena(void);
+unsigned long connection_get_stanza_text_skipped(void);
 char* connection_create_uuid(void);
 void connection_free_uuid(char *uuid);
 #ifdef HAVE_LIBMESODE
@@ -180,6 +184,7 @@ void iq_http_upload_request(HTTPUpload *upload);
 
 EntityCapabilities* caps_lookup(const char *const jid);
 void caps_close(void);
+EntityCapabilities* caps_ref(EntityCapabilities *caps);
 void caps_destroy(EntityCapabilities *caps);
 void caps_reset_ver(void);
 void caps_add_feature(char *feature);
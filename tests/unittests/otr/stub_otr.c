@@ -55,6 +55,13 @@ void otr_keygen(ProfAccount *account)
     check_expected(account);
 }
 
+gboolean otr_keygen_in_progress(void)
+{
+    return FALSE;
+}
+
+void otr_keygen_queue_start(const char *const barejid) {}
+
 gboolean otr_key_loaded(void)
 {
     return (gboolean)mock();
@@ -10,6 +10,16 @@ GHashTable* p_gpg_list_keys(void)
     return NULL;
 }
 
+guint p_gpg_key_index_count(void)
+{
+    return 0;
+}
+
+gint64 p_gpg_key_index_build_time(void)
+{
+    return 0;
+}
+
 GHashTable*
 p_gpg_pubkeys(void)
 {
@@ -23,6 +33,16 @@ const char* p_gpg_libver(void)
 
 void p_gpg_verify(const char * const barejid, const char *const sign) {}
 
+gulong p_gpg_verify_cache_hits(void)
+{
+    return 0;
+}
+
+gulong p_gpg_verify_cache_misses(void)
+{
+    return 0;
+}
+
 char* p_gpg_sign(const char * const str, const char * const fp)
 {
     return NULL;
@@ -37,11 +57,17 @@ gboolean p_gpg_available(const char * const barejid)
 {
     return FALSE;
 }
-char * p_gpg_decrypt(const char * const cipher)
+void p_gpg_encrypt_async(const char *const barejid, const char *const message, const char *const fp,
+    ProfPGPCallback callback, void *userdata) {}
+void p_gpg_decrypt_async(const char *const barejid, const char *const cipher, ProfPGPCallback callback, void *userdata) {}
+
+gboolean p_gpg_pending(const char *const barejid)
 {
-    return NULL;
+    return FALSE;
 }
 
+void p_gpg_poll(void) {}
+
 void p_gpg_on_connect(const char * const barejid) {}
 void p_gpg_on_disconnect(void) {}
 
@@ -50,8 +76,6 @@ gboolean p_gpg_addkey(const char * const jid, const char * const keyid)
     return TRUE;
 }
 
-void p_gpg_free_decrypted(char *decrypted) {}
-
 void p_gpg_free_keys(GHashTable *keys) {}
 
 void p_gpg_autocomplete_key_reset(void) {}
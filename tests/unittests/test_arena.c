@@ -0,0 +1,99 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/arena.h"
+
+static int destroyed = 0;
+
+static void
+_count_destroy(void *data)
+{
+    destroyed++;
+    free(data);
+}
+
+void arena_strdup_copies_string(void **state)
+{
+    Arena arena = arena_new(64);
+
+    char *result = arena_strdup(arena, "a message");
+
+    assert_string_equal("a message", result);
+    assert_null(arena_strdup(arena, NULL));
+
+    arena_free(arena);
+}
+
+void arena_alloc_serves_large_requests(void **state)
+{
+    Arena arena = arena_new(64);
+    char *small = arena_strdup(arena, "small");
+
+    char *large = arena_alloc(arena, 1000);
+    memset(large, 'x', 1000);
+
+    assert_string_equal("small", small);
+
+    arena_free(arena);
+}
+
+void arena_utf8_strdown_lowers_ascii(void **state)
+{
+    Arena arena = arena_new(64);
+
+    char *result = arena_utf8_strdown(arena, "Hello BoothJ5");
+
+    assert_string_equal("hello boothj5", result);
+
+    arena_free(arena);
+}
+
+void arena_utf8_strdown_lowers_non_ascii(void **state)
+{
+    Arena arena = arena_new(64);
+
+    char *result = arena_utf8_strdown(arena, "ÜBER");
+
+    assert_string_equal("über", result);
+
+    arena_free(arena);
+}
+
+void arena_reset_destroys_owned_data(void **state)
+{
+    Arena arena = arena_new(64);
+    destroyed = 0;
+
+    arena_own(arena, malloc(8), _count_destroy);
+    arena_own(arena, malloc(8), _count_destroy);
+    assert_int_equal(0, destroyed);
+
+    arena_reset(arena);
+    assert_int_equal(2, destroyed);
+
+    arena_reset(arena);
+    assert_int_equal(2, destroyed);
+
+    arena_free(arena);
+}
+
+void arena_reset_reuses_first_block(void **state)
+{
+    Arena arena = arena_new(256);
+
+    arena_strdup(arena, "first stanza");
+    arena_reset(arena);
+    arena_strdup(arena, "second stanza");
+    arena_reset(arena);
+
+    assert_int_equal(1, arena_get_blocks(arena));
+    assert_int_equal(2, arena_get_allocs(arena));
+    assert_int_equal(2, arena_get_resets(arena));
+
+    arena_free(arena);
+}
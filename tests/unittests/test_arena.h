@@ -0,0 +1,6 @@
+void arena_strdup_copies_string(void **state);
+void arena_alloc_serves_large_requests(void **state);
+void arena_utf8_strdown_lowers_ascii(void **state);
+void arena_utf8_strdown_lowers_non_ascii(void **state);
+void arena_reset_destroys_owned_data(void **state);
+void arena_reset_reuses_first_block(void **state);
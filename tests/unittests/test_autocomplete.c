@@ -7,6 +7,7 @@
 
 #include "xmpp/contact.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
 
 void clear_empty(void **state)
 {
@@ -117,3 +118,20 @@ void add_two_same_updates(void **state)
     autocomplete_clear(ac);
     g_slist_free_full(result, g_free);
 }
+
+void interned_items_released_on_remove_and_clear(void **state)
+{
+    guint count = intern_get_count();
+    Autocomplete ac = autocomplete_new_interned();
+    autocomplete_add(ac, "Hello");
+    autocomplete_add(ac, "Hello");
+    autocomplete_add(ac, "World");
+
+    assert_int_equal(count + 2, intern_get_count());
+
+    autocomplete_remove(ac, "Hello");
+    assert_int_equal(count + 1, intern_get_count());
+
+    autocomplete_free(ac);
+    assert_int_equal(count, intern_get_count());
+}
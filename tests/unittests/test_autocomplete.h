@@ -8,3 +8,4 @@ void add_two_and_complete_returns_second(void **state);
 void add_two_adds_two(void **state);
 void add_two_same_adds_one(void **state);
 void add_two_same_updates(void **state);
+void interned_items_released_on_remove_and_clear(void **state);
@@ -4,6 +4,7 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <stdlib.h>
+#include <string.h>
 
 void replace_one_substr(void **state)
 {
@@ -310,6 +311,48 @@ void utf8_display_len_all_wide(void **state)
     assert_int_equal(8, result);
 }
 
+void utf8_display_len_long_mixed(void **state)
+{
+    int result = utf8_display_len("abcdefghijklmnopqrstuvwxyz 四 abcdefghij ü");
+
+    assert_int_equal(42, result);
+}
+
+void utf8_ascii_prefix_len_null_str(void **state)
+{
+    size_t result = utf8_ascii_prefix_len(NULL, 0);
+
+    assert_int_equal(0, result);
+}
+
+void utf8_ascii_prefix_len_all_ascii(void **state)
+{
+    size_t result = utf8_ascii_prefix_len("abcdefghijklmnopqrstuvwxyz0123456789", 36);
+
+    assert_int_equal(36, result);
+}
+
+void utf8_ascii_prefix_len_stops_at_non_ascii(void **state)
+{
+    size_t result = utf8_ascii_prefix_len("abcdefghijklmnopqrstu四vwxyz", strlen("abcdefghijklmnopqrstu四vwxyz"));
+
+    assert_int_equal(21, result);
+}
+
+void utf8_ascii_prefix_len_non_ascii_first(void **state)
+{
+    size_t result = utf8_ascii_prefix_len("ひらがな", strlen("ひらがな"));
+
+    assert_int_equal(0, result);
+}
+
+void utf8_ascii_prefix_len_stops_at_len(void **state)
+{
+    size_t result = utf8_ascii_prefix_len("abcdefghijklmnopqrstuvwxyz", 11);
+
+    assert_int_equal(11, result);
+}
+
 void strip_quotes_does_nothing_when_no_quoted(void **state)
 {
     char *input = "/cmd test string";
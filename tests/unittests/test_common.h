@@ -33,6 +33,12 @@ void utf8_display_len_1_wide(void **state);
 void utf8_display_len_non_wide(void **state);
 void utf8_display_len_wide(void **state);
 void utf8_display_len_all_wide(void **state);
+void utf8_display_len_long_mixed(void **state);
+void utf8_ascii_prefix_len_null_str(void **state);
+void utf8_ascii_prefix_len_all_ascii(void **state);
+void utf8_ascii_prefix_len_stops_at_non_ascii(void **state);
+void utf8_ascii_prefix_len_non_ascii_first(void **state);
+void utf8_ascii_prefix_len_stops_at_len(void **state);
 void strip_quotes_does_nothing_when_no_quoted(void **state);
 void strip_quotes_strips_first(void **state);
 void strip_quotes_strips_last(void **state);
@@ -0,0 +1,46 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/intern.h"
+
+void intern_returns_null_for_null(void **state)
+{
+    char *result = intern_ref(NULL);
+
+    assert_null(result);
+}
+
+void intern_returns_same_string_for_equal_input(void **state)
+{
+    char input[] = "boothj5";
+
+    char *first = intern_ref("boothj5");
+    char *second = intern_ref(input);
+
+    assert_ptr_equal(first, second);
+    assert_string_equal("boothj5", first);
+
+    intern_unref(first);
+    intern_unref(second);
+}
+
+void intern_keeps_string_until_last_unref(void **state)
+{
+    guint count = intern_get_count();
+
+    char *first = intern_ref("a nick");
+    char *second = intern_ref("a nick");
+    assert_int_equal(count + 1, intern_get_count());
+
+    intern_unref(first);
+    assert_int_equal(count + 1, intern_get_count());
+    assert_string_equal("a nick", second);
+
+    intern_unref(second);
+    assert_int_equal(count, intern_get_count());
+}
@@ -0,0 +1,3 @@
+void intern_returns_null_for_null(void **state);
+void intern_returns_same_string_for_equal_input(void **state);
+void intern_keeps_string_until_last_unref(void **state);
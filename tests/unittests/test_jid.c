@@ -183,3 +183,40 @@ void returns_barejid_when_fulljid_not_exists(void **state)
 
     assert_string_equal("localpart@domainpart", result);
 }
+
+void create_returns_shared_jid_for_same_string(void **state)
+{
+    Jid *first = jid_create("myuser@mydomain/laptop");
+    Jid *second = jid_create("myuser@mydomain/laptop");
+
+    assert_ptr_equal(first, second);
+
+    jid_destroy(first);
+    assert_string_equal("myuser@mydomain", second->barejid);
+    jid_destroy(second);
+}
+
+void bare_equals_when_same_bare_part(void **state)
+{
+    assert_true(jid_bare_equals("MyUser@MyDomain/laptop", "myuser@mydomain"));
+}
+
+void bare_equals_when_no_resource(void **state)
+{
+    assert_true(jid_bare_equals("myuser@mydomain", "myuser@mydomain"));
+}
+
+void bare_not_equals_when_different(void **state)
+{
+    assert_false(jid_bare_equals("myuser@mydomain/laptop", "myuser@mydomain.org"));
+}
+
+void bare_not_equals_when_prefix(void **state)
+{
+    assert_false(jid_bare_equals("myuser@mydomain.org/laptop", "myuser@mydomain"));
+}
+
+void bare_equals_non_ascii(void **state)
+{
+    assert_true(jid_bare_equals("ÜSER@domain/laptop", "üser@domain"));
+}
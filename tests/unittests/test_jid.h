@@ -23,3 +23,9 @@ void create_with_at_and_slash_in_resource(void **state);
 void create_full_with_trailing_slash(void **state);
 void returns_fulljid_when_exists(void **state);
 void returns_barejid_when_fulljid_not_exists(void **state);
+void create_returns_shared_jid_for_same_string(void **state);
+void bare_equals_when_same_bare_part(void **state);
+void bare_equals_when_no_resource(void **state);
+void bare_not_equals_when_different(void **state);
+void bare_not_equals_when_prefix(void **state);
+void bare_equals_non_ascii(void **state);
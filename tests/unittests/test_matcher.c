@@ -0,0 +1,117 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/matcher.h"
+
+static void
+_collect(int pattern, int offset, void *userdata)
+{
+    GString *found = userdata;
+    g_string_append_printf(found, "%d@%d ", pattern, offset);
+}
+
+static char*
+_scan(Matcher matcher, const char *const text)
+{
+    GString *found = g_string_new("");
+    matcher_scan(matcher, text, _collect, found);
+    return g_string_free(found, FALSE);
+}
+
+void matcher_finds_nothing_when_no_patterns(void **state)
+{
+    Matcher matcher = matcher_new();
+
+    char *found = _scan(matcher, "some text");
+    assert_string_equal("", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
+
+void matcher_finds_single_pattern(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "boothj5");
+
+    char *found = _scan(matcher, "hello boothj5, and boothj5");
+    assert_string_equal("0@6 0@19 ", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
+
+void matcher_finds_overlapping_occurrences(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "aa");
+
+    char *found = _scan(matcher, "aaaa");
+    assert_string_equal("0@0 0@1 0@2 ", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
+
+void matcher_finds_patterns_sharing_suffix(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "he");
+    matcher_add(matcher, "she");
+    matcher_add(matcher, "his");
+    matcher_add(matcher, "hers");
+
+    char *found = _scan(matcher, "ushers");
+    assert_string_equal("1@1 0@2 3@2 ", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
+
+void matcher_reports_duplicate_patterns(void **state)
+{
+    Matcher matcher = matcher_new();
+    int first = matcher_add(matcher, "nick");
+    int second = matcher_add(matcher, "nick");
+
+    assert_int_equal(0, first);
+    assert_int_equal(1, second);
+
+    char *found = _scan(matcher, "a nick");
+    assert_string_equal("1@2 0@2 ", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
+
+void matcher_ignores_empty_pattern(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "");
+    int index = matcher_add(matcher, "b");
+
+    assert_int_equal(1, index);
+
+    char *found = _scan(matcher, "abc");
+    assert_string_equal("1@1 ", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
+
+void matcher_finds_multibyte_pattern(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "ĉapelo");
+
+    char *found = _scan(matcher, "la ĉapelo");
+    assert_string_equal("0@3 ", found);
+
+    g_free(found);
+    matcher_free(matcher);
+}
@@ -0,0 +1,7 @@
+void matcher_finds_nothing_when_no_patterns(void **state);
+void matcher_finds_single_pattern(void **state);
+void matcher_finds_overlapping_occurrences(void **state);
+void matcher_finds_patterns_sharing_suffix(void **state);
+void matcher_reports_duplicate_patterns(void **state);
+void matcher_ignores_empty_pattern(void **state);
+void matcher_finds_multibyte_pattern(void **state);
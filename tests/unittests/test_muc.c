@@ -76,3 +76,48 @@ void test_muc_active(void **state)
 
     assert_true(room_is_active);
 }
+
+void test_muc_pending_history_take_returns_in_order(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    GDateTime *timestamp = g_date_time_new_now_local();
+    muc_pending_history_add(room, "alice", timestamp, "first");
+    muc_pending_history_add(room, "carol", timestamp, "second");
+    g_date_time_unref(timestamp);
+
+    GList *history = muc_pending_history_take(room);
+
+    assert_int_equal(2, g_list_length(history));
+    MucHistory *first = history->data;
+    MucHistory *second = history->next->data;
+    assert_string_equal("alice", first->nick);
+    assert_string_equal("first", first->message);
+    assert_string_equal("carol", second->nick);
+    assert_string_equal("second", second->message);
+    assert_null(muc_pending_history_take(room));
+
+    g_list_free_full(history, (GDestroyNotify)muc_history_free);
+}
+
+void test_muc_pending_history_ignored_for_unknown_room(void **state)
+{
+    GDateTime *timestamp = g_date_time_new_now_local();
+    muc_pending_history_add("room@server.org", "alice", timestamp, "message");
+    g_date_time_unref(timestamp);
+
+    assert_null(muc_pending_history_take("room@server.org"));
+}
+
+void test_muc_pending_history_not_expired_when_recent(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    GDateTime *timestamp = g_date_time_new_now_local();
+    muc_pending_history_add(room, "alice", timestamp, "message");
+    g_date_time_unref(timestamp);
+
+    GList *expired = muc_pending_history_expired();
+
+    assert_null(expired);
+}
@@ -7,3 +7,6 @@ void test_muc_invites_count_0(void **state);
 void test_muc_invites_count_5(void **state);
 void test_muc_room_is_not_active(void **state);
 void test_muc_active(void **state);
+void test_muc_pending_history_take_returns_in_order(void **state);
+void test_muc_pending_history_ignored_for_unknown_room(void **state);
+void test_muc_pending_history_not_expired_when_recent(void **state);
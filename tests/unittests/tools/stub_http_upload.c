@@ -36,6 +36,7 @@
 #define TOOLS_HTTP_UPLOAD_H
 
 #include <curl/curl.h>
+#include <glib.h>
 
 // forward -> ui/win_types.h
 typedef struct prof_win_t ProfWin;
@@ -48,16 +49,19 @@ typedef struct http_upload_t {
     char *get_url;
     char *put_url;
     ProfWin *window;
-    pthread_t worker;
-    int cancel;
+    volatile gint cancel;
+    volatile gint progress;
+    int progress_shown;
 } HTTPUpload;
 
 //GSList *upload_processes;
 
-void* http_file_put(void *userdata) {}
+void http_upload_start(HTTPUpload *upload) {}
+void http_upload_cancel(HTTPUpload *upload) {}
+void http_upload_check(void) {}
+void http_upload_set_concurrency(int count) {}
 
-char* file_mime_type(const char* const file_name) {}
-off_t file_size(const char* const file_name) {}
+gboolean file_upload_info(const char *const file_name, off_t *size, char **mime_type) {}
 int is_regular_file(const char *filename) {}
 
 #endif
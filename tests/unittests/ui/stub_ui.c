@@ -193,7 +193,7 @@ void mucwin_occupant_affiliation_change(ProfMucWin *mucwin, const char * const n
 void mucwin_occupant_role_and_affiliation_change(ProfMucWin *mucwin, const char * const nick, const char * const role,
     const char * const affiliation, const char * const actor, const char * const reason) {}
 void mucwin_roster(ProfMucWin *mucwin, GList *occupants, const char * const presence) {}
-void mucwin_history(ProfMucWin *mucwin, const char * const nick, GDateTime *timestamp, const char * const message) {}
+void mucwin_history(ProfMucWin *mucwin, GList *history) {}
 void mucwin_message(ProfMucWin *mucwin, const char *const nick, const char *const message, GSList *mentions, GList *triggers) {}
 void mucwin_subject(ProfMucWin *mucwin, const char * const nick, const char * const subject) {}
 void mucwin_requires_config(ProfMucWin *mucwin) {}
@@ -443,9 +443,11 @@ void cons_grlog_setting(void) {}
 void cons_autoaway_setting(void) {}
 void cons_reconnect_setting(void) {}
 void cons_autoping_setting(void) {}
+void cons_upload_setting(void) {}
 void cons_autoconnect_setting(void) {}
 void cons_inpblock_setting(void) {}
 void cons_winpos_setting(void) {}
+void cons_statusbar_setting(void) {}
 void cons_tray_setting(void) {}
 
 void cons_show_contact_online(PContact contact, Resource *resource, GDateTime *last_activity)
@@ -505,6 +507,15 @@ ProfWin* win_create_plugin(const char *const plugin_name, const char * const tag
 }
 
 void win_update_virtual(ProfWin *window) {}
+void win_render_pending(ProfWin *window) {}
+gulong win_get_lines_drawn(void)
+{
+    return 0;
+}
+gulong win_get_lines_deferred(void)
+{
+    return 0;
+}
 void win_free(ProfWin *window) {}
 gboolean win_notify_remind(ProfWin *window)
 {
@@ -521,6 +532,7 @@ void win_show_subwin(ProfWin *window) {}
 void win_refresh_without_subwin(ProfWin *window) {}
 void win_refresh_with_subwin(ProfWin *window) {}
 void win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *timestamp, int flags, theme_item_t theme_item, const char * const from, const char * const message) {}
+void win_print_deferred(ProfWin *window, const char show_char, int pad_indent, GDateTime *timestamp, int flags, theme_item_t theme_item, const char * const from, const char * const message) {}
 void win_vprint(ProfWin *window, const char show_char, int pad_indent, GDateTime *timestamp, int flags, theme_item_t theme_item, const char * const from, const char * const message, ...) {}
 char* win_get_title(ProfWin *window)
 {
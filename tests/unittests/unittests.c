@@ -23,6 +23,9 @@
 #include "test_cmd_pgp.h"
 #include "test_jid.h"
 #include "test_parser.h"
+#include "test_matcher.h"
+#include "test_intern.h"
+#include "test_arena.h"
 #include "test_roster_list.h"
 #include "test_preferences.h"
 #include "test_server_events.h"
@@ -73,6 +76,12 @@ int main(int argc, char* argv[]) {
         unit_test(utf8_display_len_non_wide),
         unit_test(utf8_display_len_wide),
         unit_test(utf8_display_len_all_wide),
+        unit_test(utf8_display_len_long_mixed),
+        unit_test(utf8_ascii_prefix_len_null_str),
+        unit_test(utf8_ascii_prefix_len_all_ascii),
+        unit_test(utf8_ascii_prefix_len_stops_at_non_ascii),
+        unit_test(utf8_ascii_prefix_len_non_ascii_first),
+        unit_test(utf8_ascii_prefix_len_stops_at_len),
         unit_test(strip_quotes_does_nothing_when_no_quoted),
         unit_test(strip_quotes_strips_first),
         unit_test(strip_quotes_strips_last),
@@ -88,6 +97,7 @@ int main(int argc, char* argv[]) {
         unit_test(add_two_adds_two),
         unit_test(add_two_same_adds_one),
         unit_test(add_two_same_updates),
+        unit_test(interned_items_released_on_remove_and_clear),
 
         unit_test(create_jid_from_null_returns_null),
         unit_test(create_jid_from_empty_string_returns_null),
@@ -114,6 +124,12 @@ int main(int argc, char* argv[]) {
         unit_test(create_full_with_trailing_slash),
         unit_test(returns_fulljid_when_exists),
         unit_test(returns_barejid_when_fulljid_not_exists),
+        unit_test(create_returns_shared_jid_for_same_string),
+        unit_test(bare_equals_when_same_bare_part),
+        unit_test(bare_equals_when_no_resource),
+        unit_test(bare_not_equals_when_different),
+        unit_test(bare_not_equals_when_prefix),
+        unit_test(bare_equals_non_ascii),
 
         unit_test(parse_null_returns_null),
         unit_test(parse_empty_returns_null),
@@ -460,6 +476,9 @@ int main(int argc, char* argv[]) {
         unit_test_setup_teardown(test_muc_invites_count_5, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_room_is_not_active, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_active, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_pending_history_take_returns_in_order, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_pending_history_ignored_for_unknown_room, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_pending_history_not_expired_when_recent, muc_before_test, muc_after_test),
 
         unit_test(cmd_bookmark_shows_message_when_disconnected),
         unit_test(cmd_bookmark_shows_message_when_disconnecting),
@@ -588,6 +607,25 @@ int main(int argc, char* argv[]) {
         unit_test(prof_partial_occurrences_tests),
         unit_test(prof_whole_occurrences_tests),
 
+        unit_test(matcher_finds_nothing_when_no_patterns),
+        unit_test(matcher_finds_single_pattern),
+        unit_test(matcher_finds_overlapping_occurrences),
+        unit_test(matcher_finds_patterns_sharing_suffix),
+        unit_test(matcher_reports_duplicate_patterns),
+        unit_test(matcher_ignores_empty_pattern),
+        unit_test(matcher_finds_multibyte_pattern),
+
+        unit_test(intern_returns_null_for_null),
+        unit_test(intern_returns_same_string_for_equal_input),
+        unit_test(intern_keeps_string_until_last_unref),
+
+        unit_test(arena_strdup_copies_string),
+        unit_test(arena_alloc_serves_large_requests),
+        unit_test(arena_utf8_strdown_lowers_ascii),
+        unit_test(arena_utf8_strdown_lowers_non_ascii),
+        unit_test(arena_reset_destroys_owned_data),
+        unit_test(arena_reset_reuses_first_block),
+
         unit_test(returns_no_commands),
         unit_test(returns_commands),
 
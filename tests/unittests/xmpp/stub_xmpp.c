@@ -34,6 +34,20 @@ const char * connection_get_fulljid(void)
     return (char *)mock();
 }
 
+Arena connection_stanza_arena(void)
+{
+    static Arena arena = NULL;
+    if (arena == NULL) {
+        arena = arena_new(4096);
+    }
+    return arena;
+}
+
+unsigned long connection_get_stanza_text_skipped(void)
+{
+    return 0;
+}
+
 const char * session_get_domain(void)
 {
     return NULL;
@@ -212,6 +226,11 @@ EntityCapabilities* caps_lookup(const char * const jid)
 }
 
 void caps_close(void) {}
+EntityCapabilities* caps_ref(EntityCapabilities *caps)
+{
+    return caps;
+}
+
 void caps_destroy(EntityCapabilities *caps) {}
 void caps_reset_ver(void) {}
 gboolean caps_jid_has_feature(const char *const jid, const char *const feature)